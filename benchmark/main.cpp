@@ -0,0 +1,171 @@
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+#include "MonochromDither.hpp"
+#include "Pipeline.hpp"
+#include "Selector.hpp"
+
+
+using namespace std;
+using namespace cv;
+using namespace dither;
+
+
+typedef function<Mat(const Mat&)> Kernel;
+
+
+Mat createTestImage(const int size)
+{
+    // horizontal ramp modulated by a slow vertical wave, covers all grey levels
+    Mat img(size, size, CV_8UC3);
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            const auto ramp = 255. * x / (size - 1);
+            const auto wave = 32. * sin(2. * CV_PI * y / size);
+            img.at<Vec3b>(y, x) = Vec3b::all(saturate_cast<uint8_t>(ramp + wave));
+        }
+    }
+    return img;
+}
+
+
+void benchmark(const string& name, const Kernel& kernel, const Mat& img, const int runs)
+{
+    // warm up caches and lazily initialized state
+    kernel(img);
+    TickMeter tm;
+    for (int i = 0; i < runs; ++i)
+    {
+        tm.start();
+        kernel(img);
+        tm.stop();
+    }
+    const auto ms = tm.getTimeMilli() / runs;
+    const auto mpxs = img.total() / (ms * 1e3);
+    cout << left << setw(36) << name
+         << right << setw(10) << fixed << setprecision(2) << ms << " ms"
+         << setw(10) << mpxs << " MP/s\n";
+}
+
+
+int main(int argc, const char** argv)
+{
+    CommandLineParser parser(argc, argv,
+                             "{h help      |        | }"
+                             "{i image     |        | image to benchmark, a synthetic ramp is used if empty}"
+                             "{s size      | 2048   | edge length of the synthetic image}"
+                             "{r runs      | 10     | repetitions per kernel}");
+
+    parser.about("simple tool to measure the throughput of the dithering kernels");
+
+    if (parser.has("help"))
+    {
+        parser.printMessage();
+        return 0;
+    }
+
+    const auto imgPath = parser.get<string>("i");
+    const auto size = parser.get<int>("s");
+    const auto runs = parser.get<int>("r");
+
+    if (!parser.check()) {
+        parser.printErrors();
+        return -1;
+    }
+
+    const auto img = imgPath.empty() ? createTestImage(size) : imread(imgPath);
+
+    if (img.data == NULL)
+    {
+        cerr << "image not found\n";
+        parser.printMessage();
+        return -1;
+    }
+
+    cout << img.cols << " x " << img.rows << " pixels, " << runs << " runs\n\n";
+
+    MonochromDither monochromDither;
+
+    // raster order kernels
+    benchmark("Simple Error Diffusion", [&](const Mat& m) { return monochromDither.simpleErrorDiffusion(m); }, img, runs);
+    benchmark("Floyd-Steinberg", [&](const Mat& m) { return monochromDither.floydSteinberg(m); }, img, runs);
+    benchmark("Ostromoukhov", [&](const Mat& m) { return monochromDither.ostromoukhov(m, false); }, img, runs);
+    benchmark("Ostromoukhov (serpentine)", [&](const Mat& m) { return monochromDither.ostromoukhov(m); }, img, runs);
+
+    // space-filling curve kernels
+    benchmark("Riemersma", [&](const Mat& m) { return monochromDither.riemersma(m); }, img, runs);
+
+    // tiled kernels, a single tile covering the image runs serially
+    const auto serialTile = max(img.cols, img.rows);
+    benchmark("Block Error Diffusion (1 tile)", [&](const Mat& m) { return monochromDither.blockErrorDiffusion(m, serialTile); }, img, runs);
+    for (const auto tileSize : {16, 64, 256})
+    {
+        benchmark("Block Error Diffusion (tile " + to_string(tileSize) + ")", [&](const Mat& m) { return monochromDither.blockErrorDiffusion(m, tileSize); }, img, runs);
+    }
+
+    // class by class kernels
+    benchmark("Dot Diffusion (Knuth 8x8)", [&](const Mat& m) { return monochromDither.dotDiffusion(m, CLASS_MATRIX_TYPE::knuth_8x8); }, img, runs);
+    benchmark("Dot Diffusion (16x16)", [&](const Mat& m) { return monochromDither.dotDiffusion(m, CLASS_MATRIX_TYPE::optimized_16x16); }, img, runs);
+
+    // threshold tile lookups
+    benchmark("Ordered", [&](const Mat& m) { return monochromDither.ordered(m); }, img, runs);
+    benchmark("AM Screen", [&](const Mat& m) { return monochromDither.amScreen(m); }, img, runs);
+    benchmark("CMYK Screen (4 separations)", [&](const Mat& m) { return monochromDither.cmykScreen(m).front(); }, img, runs);
+
+    // preprocessing, one OpenCV call per step against the fused single pass
+    const Size printSize(img.cols * 3 / 4, img.rows * 3 / 4);
+    Mat gammaLut(1, 256, CV_8UC1);
+    for (int i = 0; i < 256; ++i)
+    {
+        gammaLut.at<uint8_t>(0, i) = saturate_cast<uint8_t>(255. * pow(i / 255., 2.2));
+    }
+    benchmark("Preprocessing (separate passes)", [&](const Mat& m)
+    {
+        Mat grayImg, blurImg, sharpImg, dstImg;
+        cvtColor(m, grayImg, COLOR_BGR2GRAY);
+        LUT(grayImg, gammaLut, grayImg);
+        GaussianBlur(grayImg, blurImg, Size(3, 3), 0.);
+        addWeighted(grayImg, 1.8, blurImg, -.8, 0., sharpImg);
+        resize(sharpImg, dstImg, printSize, 0., 0., INTER_LINEAR);
+        return dstImg;
+    }, img, runs);
+    Pipeline pipeline;
+    pipeline.gamma(2.2).unsharp(.8).resize(printSize);
+    benchmark("Preprocessing (fused pipeline)", [&](const Mat& m) { return pipeline.process(m); }, img, runs);
+    benchmark("Pipeline + Floyd-Steinberg", [&](const Mat& m) { return pipeline.apply(m, monochromDither, METHOD::floyd_steinberg); }, img, runs);
+
+    cout << "\nthread scaling\n";
+    for (int threads = 1; threads <= getNumberOfCPUs(); threads *= 2)
+    {
+        setNumThreads(threads);
+        const auto suffix = " (" + to_string(threads) + " threads)";
+        benchmark("Dot Diffusion" + suffix, [&](const Mat& m) { return monochromDither.dotDiffusion(m); }, img, runs);
+        benchmark("Block Error Diffusion" + suffix, [&](const Mat& m) { return monochromDither.blockErrorDiffusion(m); }, img, runs);
+    }
+    setNumThreads(-1);
+
+    // the calibration is done with the restored thread count
+    Selector selector(monochromDither);
+    cout << "\nmethod selection by latency budget (predicted / measured ms)\n";
+    for (const auto budgetMs : {1., 5., 20., 100., 500.})
+    {
+        Selector::Choice choice;
+        TickMeter tm;
+        tm.start();
+        selector.apply(img, budgetMs, &choice);
+        tm.stop();
+        cout << "budget " << setw(6) << budgetMs << " ms: method " << setw(2) << (int)choice.method
+             << (choice.withinBudget ? "  " : " !") << fixed << setprecision(2)
+             << setw(10) << choice.predictedMs << setw(10) << tm.getTimeMilli() << "\n";
+    }
+
+    return 0;
+}
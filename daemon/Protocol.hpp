@@ -0,0 +1,57 @@
+#ifndef DITHER_PROTOCOL_HPP
+#define DITHER_PROTOCOL_HPP
+
+#include <cstdint>
+
+
+namespace dither
+{
+    namespace service
+    {
+        // Unix domain socket the daemon listens on if no other path is given
+        const char* const defaultSocketPath = "/tmp/dither.sock";
+
+        const uint32_t requestMagic = 0x48544944; // "DITH"
+
+        // larger images are rejected as bad requests before anything is mapped
+        const int32_t maxImageSide = 32768;
+
+        /*  A client places a BGR image (CV_8UC3, rows without padding) at
+            inputOffset of a POSIX shared memory segment and reserves
+            width * height bytes at outputOffset for the monochrom result.  The
+            daemon maps the segment, reads the image where it is, writes the result
+            into the segment and answers with a Response carrying the same id.
+            Several requests may be in flight on one connection, responses are not
+            necessarily sent in request order.
+        */
+        struct Request
+        {
+            uint32_t magic;
+            uint32_t method;        // dither::METHOD
+            uint64_t id;
+            int32_t width;
+            int32_t height;
+            uint64_t inputOffset;
+            uint64_t outputOffset;
+            char shmName[32];       // NUL terminated, starts with '/'
+        };
+
+        enum STATUS
+        {
+            ok,
+            bad_request,
+            shm_error,
+            dither_error
+        };
+
+        struct Response
+        {
+            uint64_t id;
+            int32_t status;         // dither::service::STATUS
+            int32_t reserved;
+        };
+    }
+}
+
+
+#endif //DITHER_PROTOCOL_HPP
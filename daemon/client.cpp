@@ -0,0 +1,260 @@
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/imgcodecs.hpp"
+#include "MonochromDither.hpp"
+#include "Protocol.hpp"
+
+// after the dither headers, <sys/mman.h> defines a MAP_TYPE macro on Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+using namespace std;
+using namespace cv;
+using namespace dither;
+using namespace dither::service;
+
+
+namespace
+{
+    Mat createTestImage(const int size)
+    {
+        Mat img(size, size, CV_8UC3);
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                img.at<Vec3b>(y, x) = Vec3b::all((uint8_t)((x + y) * 255 / (2 * size - 2)));
+            }
+        }
+        return img;
+    }
+
+
+    int connectTo(const string& socketPath)
+    {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        const auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (const sockaddr*)&addr, sizeof(addr)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+
+    bool transfer(const int fd, void* data, const size_t size, const bool sending)
+    {
+        size_t done = 0;
+        while (done < size)
+        {
+            const auto n = sending ? send(fd, (const char*)data + done, size - done, 0)
+                                   : recv(fd, (char*)data + done, size - done, 0);
+            if (n <= 0)
+            {
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+
+    // One client with its own shared memory segment and connection. The image
+    // is written into the segment once, every request then only travels as a
+    // small message over the socket.
+    bool runClient(const int index, const string& socketPath, const Mat& img, const Mat& expected,
+                   const METHOD method, const int requests, double& latencyMs)
+    {
+        const auto shmName = "/dither." + to_string(getpid()) + "." + to_string(index);
+        const auto inputSize = img.total() * 3;
+        const auto segmentSize = inputSize + img.total();
+
+        const auto shmFd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (shmFd < 0 || ftruncate(shmFd, segmentSize) < 0)
+        {
+            cerr << "client " << index << ": cannot create shared memory\n";
+            if (shmFd >= 0)
+            {
+                close(shmFd);
+                shm_unlink(shmName.c_str());
+            }
+            return false;
+        }
+        auto addr = mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+        close(shmFd);
+        if (addr == MAP_FAILED)
+        {
+            shm_unlink(shmName.c_str());
+            return false;
+        }
+        Mat srcImg(img.size(), CV_8UC3, addr);
+        Mat dstImg(img.size(), CV_8UC1, (uint8_t*)addr + inputSize);
+        img.copyTo(srcImg);
+
+        auto success = true;
+        const auto fd = connectTo(socketPath);
+        if (fd < 0)
+        {
+            cerr << "client " << index << ": cannot connect to " << socketPath << "\n";
+            success = false;
+        }
+
+        Request request;
+        memset(&request, 0, sizeof(request));
+        request.magic = requestMagic;
+        request.method = method;
+        request.width = img.cols;
+        request.height = img.rows;
+        request.inputOffset = 0;
+        request.outputOffset = inputSize;
+        strncpy(request.shmName, shmName.c_str(), sizeof(request.shmName) - 1);
+
+        TickMeter tm;
+        for (int i = 0; success && i < requests; ++i)
+        {
+            request.id = i;
+            // clear the output so the result of the previous request cannot pass
+            dstImg.setTo(Scalar::all(0));
+            Response response;
+            tm.start();
+            success = transfer(fd, &request, sizeof(request), true)
+                   && transfer(fd, &response, sizeof(response), false);
+            tm.stop();
+            if (success && (response.id != request.id || response.status != STATUS::ok))
+            {
+                cerr << "client " << index << ": request " << i << " failed with status " << response.status << "\n";
+                success = false;
+            }
+            if (success && !expected.empty() && norm(dstImg, expected, NORM_L1) != 0.)
+            {
+                cerr << "client " << index << ": result differs from in-process dithering\n";
+                success = false;
+            }
+        }
+        latencyMs = tm.getTimeMilli() / max(requests, 1);
+
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        munmap(addr, segmentSize);
+        shm_unlink(shmName.c_str());
+        return success;
+    }
+}
+
+
+int main(int argc, const char** argv)
+{
+    CommandLineParser parser(argc, argv,
+                             "{h help      |                  | }"
+                             "{s socket    | /tmp/dither.sock | unix domain socket of the daemon}"
+                             "{i image     |                  | image to dither, a synthetic ramp is used if empty}"
+                             "{m method    | 7                | dithering method, see dither::METHOD}"
+                             "{c clients   | 4                | number of concurrent clients}"
+                             "{r requests  | 20               | requests per client}");
+
+    parser.about("test client for the dithering daemon");
+
+    if (parser.has("help"))
+    {
+        parser.printMessage();
+        return 0;
+    }
+
+    const auto socketPath = parser.get<string>("s");
+    const auto imgPath = parser.get<string>("i");
+    const auto method = (METHOD)parser.get<int>("m");
+    const auto clients = max(parser.get<int>("c"), 1);
+    const auto requests = max(parser.get<int>("r"), 1);
+
+    if (!parser.check()) {
+        parser.printErrors();
+        return -1;
+    }
+
+    const auto img = imgPath.empty() ? createTestImage(512) : imread(imgPath);
+
+    if (img.data == NULL)
+    {
+        cerr << "image not found\n";
+        parser.printMessage();
+        return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    // the random methods cannot be compared against a local result
+    Mat expected;
+    if (method != METHOD::noise_threshold && method != METHOD::random_dither)
+    {
+        MonochromDither monochromDither;
+        try
+        {
+            expected = monochromDither.apply(img, method);
+        }
+        catch (const cv::Exception&)
+        {
+            cerr << "unknown method " << (int)method << "\n";
+            return -1;
+        }
+    }
+
+    vector<thread> threads;
+    vector<double> latencies(clients, 0.);
+    atomic<int> failures(0);
+    TickMeter tm;
+    tm.start();
+    for (int i = 0; i < clients; ++i)
+    {
+        threads.emplace_back([&, i]
+        {
+            if (!runClient(i, socketPath, img, expected, method, requests, latencies[i]))
+            {
+                ++failures;
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    tm.stop();
+
+    double latency = 0.;
+    for (const auto l : latencies)
+    {
+        latency += l / clients;
+    }
+    cout << clients << " clients x " << requests << " requests, " << img.cols << " x " << img.rows << " pixels\n"
+         << fixed << setprecision(2)
+         << "mean latency " << latency << " ms, "
+         << clients * requests / tm.getTimeSec() << " images/s\n";
+
+    if (failures > 0)
+    {
+        cerr << failures << " clients failed\n";
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,478 @@
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgproc.hpp"
+#include "MonochromDither.hpp"
+#include "Protocol.hpp"
+
+// after the dither headers, <sys/mman.h> defines a MAP_TYPE macro on Linux
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+using namespace std;
+using namespace cv;
+using namespace dither;
+using namespace dither::service;
+
+
+namespace
+{
+    volatile sig_atomic_t running = 1;
+    int wakeupPipe[2] = {-1, -1};
+
+
+    void onSignal(int)
+    {
+        running = 0;
+        const char wakeup = 0;
+        if (write(wakeupPipe[1], &wakeup, 1) < 0)
+        {
+            // poll is interrupted by the signal anyway
+        }
+    }
+
+
+    struct Mapping
+    {
+        uint8_t* addr;
+        size_t size;
+        dev_t device;
+        ino_t inode;
+    };
+
+
+    // A client connection and the shared memory segments it has used so far.
+    // Segments stay mapped until the connection is gone, so a client reusing
+    // its segment pays for mmap only once.
+    class Connection
+    {
+    public:
+        explicit Connection(const int fd) : fd(fd) {}
+
+        ~Connection()
+        {
+            for (auto& mapping : mappings)
+            {
+                munmap(mapping.second.addr, mapping.second.size);
+            }
+            for (auto& mapping : retired)
+            {
+                munmap(mapping.addr, mapping.size);
+            }
+            close(fd);
+        }
+
+        bool mapSegment(const string& name, const size_t minSize, Mapping& mapping)
+        {
+            lock_guard<mutex> lock(mappingMutex);
+            // the segment is looked up on every request, a client may have
+            // shrunk it or replaced it by a new one under the same name
+            const auto shmFd = shm_open(name.c_str(), O_RDWR, 0);
+            if (shmFd < 0)
+            {
+                return false;
+            }
+            struct stat info;
+            if (fstat(shmFd, &info) != 0 || (size_t)info.st_size < minSize)
+            {
+                close(shmFd);
+                return false;
+            }
+            auto it = mappings.find(name);
+            if (it != mappings.end() && it->second.device == info.st_dev && it->second.inode == info.st_ino
+                && it->second.size <= (size_t)info.st_size && it->second.size >= minSize)
+            {
+                close(shmFd);
+                mapping = it->second;
+                return true;
+            }
+            const auto addr = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+            close(shmFd);
+            if (addr == MAP_FAILED)
+            {
+                return false;
+            }
+            // the old mapping may still be in use by another request of this
+            // connection and is released with it
+            if (it != mappings.end())
+            {
+                retired.push_back(it->second);
+            }
+            mapping = {(uint8_t*)addr, (size_t)info.st_size, info.st_dev, info.st_ino};
+            mappings[name] = mapping;
+            return true;
+        }
+
+        void respond(const Response& response)
+        {
+            lock_guard<mutex> lock(writeMutex);
+            auto data = (const char*)&response;
+            size_t sent = 0;
+            while (sent < sizeof(response))
+            {
+                const auto n = send(fd, data + sent, sizeof(response) - sent, 0);
+                if (n <= 0)
+                {
+                    return;
+                }
+                sent += n;
+            }
+        }
+
+    public:
+        const int fd;
+        vector<char> received;
+
+    private:
+        mutex mappingMutex;
+        map<string, Mapping> mappings;
+        vector<Mapping> retired;
+        mutex writeMutex;
+
+    private:
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+    };
+
+
+    struct Job
+    {
+        shared_ptr<Connection> connection;
+        Request request;
+    };
+
+
+    class JobQueue
+    {
+    public:
+        void push(const Job& job)
+        {
+            {
+                lock_guard<mutex> lock(jobMutex);
+                jobs.push_back(job);
+            }
+            jobAvailable.notify_one();
+        }
+
+        // waits for at least one job and takes up to maxJobs at once
+        bool popBatch(vector<Job>& batch, const size_t maxJobs)
+        {
+            unique_lock<mutex> lock(jobMutex);
+            jobAvailable.wait(lock, [this] { return stopped || !jobs.empty(); });
+            batch.clear();
+            while (!jobs.empty() && batch.size() < maxJobs)
+            {
+                batch.push_back(jobs.front());
+                jobs.pop_front();
+            }
+            return !batch.empty();
+        }
+
+        void stop()
+        {
+            {
+                lock_guard<mutex> lock(jobMutex);
+                stopped = true;
+            }
+            jobAvailable.notify_all();
+        }
+
+    private:
+        mutex jobMutex;
+        condition_variable jobAvailable;
+        deque<Job> jobs;
+        bool stopped = false;
+    };
+
+
+    STATUS process(MonochromDither& monochromDither, Connection& connection, const Request& request)
+    {
+        const auto nameEnd = (const char*)memchr(request.shmName, '\0', sizeof(request.shmName));
+        if (request.magic != requestMagic || nameEnd == NULL || request.shmName[0] != '/'
+            || request.width <= 0 || request.height <= 0
+            || request.width > maxImageSide || request.height > maxImageSide)
+        {
+            return STATUS::bad_request;
+        }
+        const auto pixels = (uint64_t)request.width * (uint64_t)request.height;
+        const auto inputEnd = request.inputOffset + pixels * 3;
+        const auto outputEnd = request.outputOffset + pixels;
+        if (inputEnd < request.inputOffset || outputEnd < request.outputOffset
+            || (request.outputOffset < inputEnd && request.inputOffset < outputEnd))
+        {
+            return STATUS::bad_request;
+        }
+
+        Mapping mapping;
+        if (!connection.mapSegment(request.shmName, max(inputEnd, outputEnd), mapping))
+        {
+            return STATUS::shm_error;
+        }
+
+        // both images are only headers on the shared segment, the grey image is
+        // written into the output area and kernels working in place dither it there
+        const Mat srcImg(request.height, request.width, CV_8UC3, mapping.addr + request.inputOffset);
+        Mat dstImg(request.height, request.width, CV_8UC1, mapping.addr + request.outputOffset);
+        try
+        {
+            cvtColor(srcImg, dstImg, COLOR_BGR2GRAY);
+            const auto dithImg = monochromDither.applyInPlace(dstImg, (METHOD)request.method);
+            if (dithImg.data != dstImg.data)
+            {
+                if (dithImg.size() != dstImg.size() || dithImg.type() != dstImg.type())
+                {
+                    return STATUS::dither_error;
+                }
+                dithImg.copyTo(dstImg);
+            }
+        }
+        catch (const cv::Exception&)
+        {
+            return STATUS::dither_error;
+        }
+        catch (const std::exception&)
+        {
+            // e.g. std::bad_alloc for an image the daemon cannot hold
+            return STATUS::dither_error;
+        }
+        return STATUS::ok;
+    }
+
+
+    void dispatch(JobQueue& queue, const size_t maxBatch)
+    {
+        // the dithering methods only read the shared tables of the instance
+        MonochromDither monochromDither;
+        const auto run = [&](const Job& job)
+        {
+            const Response response = {job.request.id, process(monochromDither, *job.connection, job.request), 0};
+            job.connection->respond(response);
+        };
+        vector<Job> batch;
+        while (queue.popBatch(batch, maxBatch))
+        {
+            // a single job parallelizes internally, a batch of jobs is spread
+            // over the worker threads one job per thread
+            if (batch.size() == 1)
+            {
+                run(batch.front());
+            }
+            else
+            {
+                parallel_for_(Range(0, (int)batch.size()), [&](const Range& range)
+                {
+                    for (int i = range.start; i < range.end; ++i)
+                    {
+                        run(batch[i]);
+                    }
+                });
+            }
+            batch.clear();
+        }
+    }
+
+
+    int listenOn(const string& socketPath)
+    {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(addr.sun_path))
+        {
+            cerr << "socket path too long\n";
+            return -1;
+        }
+        strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+        // only a stale socket left behind by a daemon that is gone is removed
+        struct stat info;
+        if (lstat(socketPath.c_str(), &info) == 0)
+        {
+            if (!S_ISSOCK(info.st_mode))
+            {
+                cerr << socketPath << " exists and is not a socket\n";
+                return -1;
+            }
+            const auto probeFd = socket(AF_UNIX, SOCK_STREAM, 0);
+            const auto alive = probeFd >= 0 && connect(probeFd, (const sockaddr*)&addr, sizeof(addr)) == 0;
+            if (probeFd >= 0)
+            {
+                close(probeFd);
+            }
+            if (alive)
+            {
+                cerr << "another daemon is listening on " << socketPath << "\n";
+                return -1;
+            }
+            unlink(socketPath.c_str());
+        }
+
+        const auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            perror("socket");
+            return -1;
+        }
+        // requests make the daemon open, read and write shared memory with its
+        // own rights, so only the user running it may connect
+        const auto oldMask = umask(0177);
+        const auto bound = bind(fd, (const sockaddr*)&addr, sizeof(addr)) == 0;
+        umask(oldMask);
+        if (!bound || listen(fd, SOMAXCONN) < 0)
+        {
+            perror("bind");
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+
+    // reads what the client has sent and queues every complete request
+    bool receive(const shared_ptr<Connection>& connection, JobQueue& queue)
+    {
+        char buffer[4096];
+        const auto n = recv(connection->fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+            return false;
+        }
+        if (n < 0)
+        {
+            return true;
+        }
+        auto& received = connection->received;
+        received.insert(received.end(), buffer, buffer + n);
+        size_t offset = 0;
+        while (received.size() - offset >= sizeof(Request))
+        {
+            Job job;
+            job.connection = connection;
+            memcpy(&job.request, received.data() + offset, sizeof(Request));
+            queue.push(job);
+            offset += sizeof(Request);
+        }
+        received.erase(received.begin(), received.begin() + offset);
+        return true;
+    }
+}
+
+
+int main(int argc, const char** argv)
+{
+    CommandLineParser parser(argc, argv,
+                             "{h help      |                  | }"
+                             "{s socket    | /tmp/dither.sock | unix domain socket to listen on}"
+                             "{t threads   | 0                | worker threads, 0 uses all cores}"
+                             "{b batch     | 16               | maximum number of requests processed together}");
+
+    parser.about("local dithering service, images are exchanged through POSIX shared memory");
+
+    if (parser.has("help"))
+    {
+        parser.printMessage();
+        return 0;
+    }
+
+    const auto socketPath = parser.get<string>("s");
+    const auto threads = parser.get<int>("t");
+    const auto maxBatch = (size_t)max(parser.get<int>("b"), 1);
+
+    if (!parser.check()) {
+        parser.printErrors();
+        return -1;
+    }
+
+    if (pipe(wakeupPipe) < 0)
+    {
+        perror("pipe");
+        return -1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    const auto listenFd = listenOn(socketPath);
+    if (listenFd < 0)
+    {
+        return -1;
+    }
+
+    // spin up the worker pool once for the lifetime of the service
+    if (threads > 0)
+    {
+        setNumThreads(threads);
+    }
+    JobQueue queue;
+    thread dispatcher(dispatch, ref(queue), maxBatch);
+
+    cout << "listening on " << socketPath << " with " << getNumThreads() << " worker threads\n";
+
+    map<int, shared_ptr<Connection>> connections;
+    vector<pollfd> fds;
+    while (running)
+    {
+        fds.clear();
+        fds.push_back({wakeupPipe[0], POLLIN, 0});
+        fds.push_back({listenFd, POLLIN, 0});
+        for (const auto& connection : connections)
+        {
+            fds.push_back({connection.first, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+        if (fds[1].revents & POLLIN)
+        {
+            const auto fd = accept(listenFd, NULL, NULL);
+            if (fd >= 0)
+            {
+                connections[fd] = make_shared<Connection>(fd);
+            }
+        }
+        for (size_t i = 2; i < fds.size(); ++i)
+        {
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+            auto it = connections.find(fds[i].fd);
+            // jobs still in flight keep the connection alive until they are done
+            if (!receive(it->second, queue))
+            {
+                connections.erase(it);
+            }
+        }
+    }
+
+    queue.stop();
+    dispatcher.join();
+    connections.clear();
+    close(listenFd);
+    unlink(socketPath.c_str());
+    return 0;
+}
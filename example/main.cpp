@@ -2,6 +2,7 @@
 
 #include "opencv2/highgui/highgui.hpp"
 #include "MonochromDither.hpp"
+#include "Pipeline.hpp"
 
 
 using namespace std;
@@ -47,12 +48,18 @@ int main(int argc, const char** argv)
 
     imshow("Simple Error Diffusion", monochromDither.simpleErrorDiffusion(rawImg));
     imshow("Floyd-Steinberg", monochromDither.floydSteinberg(rawImg));
+    imshow("Ostromoukhov", monochromDither.ostromoukhov(rawImg));
+    imshow("Riemersma", monochromDither.riemersma(rawImg));
+    imshow("Block Error Diffusion", monochromDither.blockErrorDiffusion(rawImg));
+    imshow("Dot Diffusion", monochromDither.dotDiffusion(rawImg));
     imshow("Fixed Threshold", monochromDither.fixedTreshold(rawImg, threshold));
     imshow("Fixed Treshold With Noise", monochromDither.noiseTreshold(rawImg, noiseThreshold, threshold));
     imshow("Ordered", monochromDither.ordered(rawImg));
+    imshow("AM Screen", monochromDither.amScreen(rawImg));
     imshow("Random", monochromDither.random(rawImg));
     imshow("Dispersed Pattern", monochromDither.patterned(rawImg, PATTERN_TYPE::dispersed));
     imshow("Clustered Pattern", monochromDither.patterned(rawImg, PATTERN_TYPE::clustered));
+    imshow("Preprocessed Floyd-Steinberg", Pipeline().gamma(1.2).unsharp(.8).apply(rawImg, monochromDither, METHOD::floyd_steinberg));
     imshow("Raw Image", rawImg);
 
     cout << "Press any key to quit.\n";
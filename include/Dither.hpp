@@ -1,6 +1,10 @@
 #ifndef DITHER_HPP
 #define DITHER_HPP
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
 #include "opencv2/core.hpp"
@@ -11,18 +15,55 @@ namespace dither
 {
     class Dither
     {
+    public:
+        /*  Dithers an image row by row, so that a producer of grey rows like the
+            Pipeline can hand over every row as soon as it is ready.  Rows are
+            pushed in raster order.  A method looking ahead writes a row later
+            than it is pushed, finish() writes the remaining ones.  If parallel()
+            is true, rows do not depend on each other and may be pushed by several
+            threads in any order.
+        */
+        class RowDither
+        {
+        public:
+            virtual ~RowDither() {}
+            virtual bool parallel() const = 0;
+            virtual void push(const int y, const uint8_t* grayRow, uint8_t* dithRow) = 0;
+            virtual void finish() {}
+        };
+
     public:
         Dither();
         ~Dither();
 
     public:
-        virtual cv::Mat fixedTreshold(const cv::Mat& srcImg, const uint8_t threshold) = 0;
-        virtual cv::Mat noiseTreshold(const cv::Mat& srcImg, const uint8_t noiseThreshold, const uint8_t threshold) = 0;
+        // dithers with the given method using its default parameters
+        cv::Mat apply(const cv::Mat& srcImg, const METHOD method);
+
+        // like apply for a grey image, which may be dithered in its own memory
+        // and overwritten; the default dithers a copy
+        virtual cv::Mat applyInPlace(cv::Mat& grayImg, const METHOD method);
+
+        // row by row version of a method with its default parameters, empty if
+        // the method needs the whole image at once
+        virtual std::unique_ptr<RowDither> rowDither(const METHOD method, const int width);
+
+    public:
+        virtual cv::Mat fixedTreshold(const cv::Mat& srcImg, const uint8_t threshold = defaultThreshold) = 0;
+        virtual cv::Mat noiseTreshold(const cv::Mat& srcImg, const uint8_t noiseThreshold = defaultNoiseThreshold, const uint8_t threshold = defaultThreshold) = 0;
         virtual cv::Mat random(const cv::Mat& srcImg) = 0;
         virtual cv::Mat patterned(const cv::Mat& srcImg, const PATTERN_TYPE type) = 0;
-        virtual cv::Mat ordered(const cv::Mat& srcImg, const MAP_TYPE type = MAP_TYPE::bayer_4x4) = 0;
+        virtual cv::Mat ordered(const cv::Mat& srcImg, const MAP_TYPE type = defaultMapType) = 0;
         virtual cv::Mat simpleErrorDiffusion(const cv::Mat& srcImg) = 0;
         virtual cv::Mat floydSteinberg(const cv::Mat &srcImg) = 0;
+        virtual cv::Mat riemersma(const cv::Mat& srcImg) = 0;
+        virtual cv::Mat ostromoukhov(const cv::Mat& srcImg, const bool serpentine = defaultSerpentine) = 0;
+        virtual cv::Mat blockErrorDiffusion(const cv::Mat& srcImg, const int tileSize = defaultTileSize) = 0;
+        virtual cv::Mat dotDiffusion(const cv::Mat& srcImg, const CLASS_MATRIX_TYPE type = defaultClassMatrix) = 0;
+        virtual cv::Mat amScreen(const cv::Mat& srcImg, const double angle = defaultScreen.angle, const double lpi = defaultScreen.lpi, const double dpi = defaultDpi) = 0;
+        virtual std::vector<cv::Mat> cmykScreen(const cv::Mat& srcImg, const double dpi = defaultDpi,
+                                                const Screen cyan = {15., 150.}, const Screen magenta = {75., 150.},
+                                                const Screen yellow = {0., 150.}, const Screen black = {45., 150.}) = 0;
 
     protected:
         std::vector<const cv::Mat> clusteredPatterns;
@@ -30,8 +71,27 @@ namespace dither
         void createClusteredPatterns();
         void createDispersedPatterns();
 
+    protected:
+        static const int hilbertOrder = 6;
+        static const int hilbertSize = 1 << hilbertOrder;
+        std::vector<uint16_t> hilbertCurve;
+        void createHilbertCurve();
+
+    protected:
+        std::vector<cv::Mat> classMatrices;
+        void createClassMatrices();
+
+    protected:
+        // threshold tiles by (angle, lpi, dpi), at most maxScreenTiles of at most
+        // 256 x 256 pixels are kept, tiles of further screens are recomputed
+        static const size_t maxScreenTiles = 64;
+        std::map<std::tuple<double, double, double>, cv::Mat> screenTiles;
+        std::mutex screenTilesMutex;
+        cv::Mat screenTile(const double angle, const double lpi, const double dpi);
+
     protected:
         uint8_t saturated_add(uint8_t val1, int8_t val2);
+        void toGray(const cv::Mat& srcImg, cv::Mat& grayImg);
     };
 }
 
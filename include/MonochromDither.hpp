@@ -34,8 +34,8 @@ namespace dither
             from one intensity or shade to another is very conspicuous is known as
             contouring.
         */
-        cv::Mat fixedTreshold(const cv::Mat& srcImg, const uint8_t threshold = 128) override;
-        cv::Mat noiseTreshold(const cv::Mat& srcImg, const uint8_t noiseThreshold = 64, const uint8_t threshold = 128) override;
+        cv::Mat fixedTreshold(const cv::Mat& srcImg, const uint8_t threshold = defaultThreshold) override;
+        cv::Mat noiseTreshold(const cv::Mat& srcImg, const uint8_t noiseThreshold = defaultNoiseThreshold, const uint8_t threshold = defaultThreshold) override;
 
 
         /*  Random dither
@@ -270,7 +270,7 @@ namespace dither
             This artifacting is the major drawback of an otherwise powerful and very
             fast technique.
         */
-        cv::Mat ordered(const cv::Mat& srcImg, const MAP_TYPE type = MAP_TYPE::bayer_4x4) override;
+        cv::Mat ordered(const cv::Mat& srcImg, const MAP_TYPE type = defaultMapType) override;
 
 
         cv::Mat simpleErrorDiffusion(const cv::Mat& srcImg) override;
@@ -335,6 +335,174 @@ namespace dither
             below) to give acceptable results.
         */
         cv::Mat floydSteinberg(const cv::Mat &srcImg) override;
+
+
+        /*  Riemersma dither
+
+            Thiadmer Riemersma's algorithm replaces the raster scan of the classic
+            error diffusion filters by a walk along a space-filling curve.  The
+            Hilbert curve visits every pixel of a square exactly once, and two pixels
+            which follow each other on the curve are always direct neighbours in the
+            image.  Because the curve keeps turning, the error is not pushed into one
+            preferred direction and the "worms" of Floyd-Steinberg disappear.
+
+            The error is not distributed to fixed neighbours.  Instead the quantization
+            errors of the last 16 pixels on the curve are kept in a queue and added to
+            the current pixel with exponentially increasing weights, the newest error
+            weighted 16 times stronger than the oldest one:
+
+
+                e[-16] ... e[-3]  e[-2]  e[-1]  *       weights 1 ... 16  (1/16)
+
+
+            The image is cut into 64 x 64 blocks which are walked block by block with
+            a precomputed curve, so that all accesses of one block stay in the cache.
+            The curve of each block ends next to the start of the block to its right,
+            which keeps the walk continuous along a row of full blocks.  It is not
+            continuous everywhere: a block clipped at the right or bottom border
+            skips the pixels outside the image in the middle of its curve, and each
+            row of blocks starts again at the left border.  At such a jump the
+            queued errors belong to pixels far away, so the queue is cleared and
+            their error is lost.
+        */
+        cv::Mat riemersma(const cv::Mat& srcImg) override;
+
+
+        /*  Ostromoukhov's variable-coefficient error diffusion
+
+            A fixed filter like Floyd-Steinberg produces regular structures at some
+            grey levels, e.g. the checkerboard at 1/2 or visible worms near 1/4 and
+            3/4.  Ostromoukhov [7] spreads the error only to three neighbours, but
+            picks the weights depending on the input level of the current pixel:
+
+
+                      *   r
+                 dl   d         (1/(r+dl+d))
+
+
+            The 128 weight triplets for the levels 0 to 127 were optimized for blue
+            noise behaviour, the levels 128 to 255 use the mirrored entries.  Per
+            pixel this costs no more than Floyd-Steinberg, the weights are a lookup
+            in a 256 entry table and all arithmetic is done in fixed point.
+
+            With serpentine scanning every second row is processed from right to
+            left with the filter mirrored, which breaks up the remaining directional
+            artifacts.
+        */
+        cv::Mat ostromoukhov(const cv::Mat& srcImg, const bool serpentine = defaultSerpentine) override;
+
+
+        /*  Block error diffusion
+
+            Every pixel of a Floyd-Steinberg dither depends on all pixels scanned
+            before it, so the filter cannot simply be split across several cores.
+            Block error diffusion cuts the image into tiles of tileSize pixels and
+            hands the error on to the neighbouring tiles, so the result is the
+            same as a serial diffusion and there are no seams at the tile borders.
+
+            A pixel receives error from its left neighbour and from the three
+            pixels above it.  The tiles lean one pixel to the left per row, so a
+            tile only waits for the tile on its left and the two tiles above and
+            above right.  The tiles are processed in a skewed wavefront: all tiles
+            of a step run in parallel and a row of tiles starts three steps after
+            the row above.  Smaller tiles give more tiles per step but more steps;
+            an image of 2048 x 2048 pixels in tiles of 64 pixels takes 125 steps
+            with about 8 tiles each.
+
+            The diffusion works on integer errors, thresholds at 128 and drops the
+            error leaving the image, so it differs slightly from floydSteinberg(),
+            which thresholds at 127, saturates the diffused error and skips the
+            diffusion at the image border.
+        */
+        cv::Mat blockErrorDiffusion(const cv::Mat& srcImg, const int tileSize = defaultTileSize) override;
+
+
+        /*  Dot diffusion
+
+            Knuth's dot diffusion [5] combines the ordered dither with the error
+            diffusion.  Like for the ordered dither, the image is covered with copies
+            of a small class matrix which assigns a class number to every pixel of a
+            tile:
+
+
+                34 48 40 32 29 15 23 31
+                42 58 56 53 21  5  7 10
+                50 62 61 45 13  1  2 18
+                38 46 54 37 25 17  9 26
+                28 14 22 30 35 49 41 33
+                20  4  6 11 43 59 57 52
+                12  0  3 19 51 63 60 44
+                24 16  8 27 39 47 55 36
+
+
+            The pixels are quantized class by class.  The error of a pixel is spread
+            over those of its 8 neighbours which have a higher class and therefore are
+            not quantized yet, orthogonal neighbours with weight 2, diagonal ones with
+            weight 1.  A pixel without such neighbours (Knuth calls it a "baron")
+            cannot pass on its error.
+
+            The result looks close to an error diffusion, but the error never travels
+            further than one tile.  All pixels of the same class are independent of
+            each other, so each class is processed in parallel over the whole image.
+
+            Mese and Vaidyanathan [6] showed that the quality improves considerably
+            with class matrices optimized for a model of the human visual system.  The
+            optimized_8x8 and optimized_16x16 matrices were derived in that way and
+            keep less than half of the filtered error of Knuth's matrix on flat
+            grey patches, although they contain a few more barons.
+        */
+        cv::Mat dotDiffusion(const cv::Mat& srcImg, const CLASS_MATRIX_TYPE type = defaultClassMatrix) override;
+
+
+        /*  AM screening
+
+            The clustered ordered dither is a digital stand-in for the screens of
+            offset printing, but its 3 x 3 cells are tiny and always axis aligned.  A
+            real halftone screen is described by its frequency in lines per inch
+            (lpi) and its angle.  At the device resolution (dpi) one screen cell
+            spans dpi / lpi pixels, usually not a whole number and rotated against
+            the pixel grid.
+
+            Rounding the cell to whole pixels would distort angle and frequency
+            noticeably.  Instead a super-cell of several cells is rounded, which
+            repeats exactly after a small number of pixels.  Its threshold tile is
+            computed once per (angle, lpi, dpi) and kept for up to 64 screens, after
+            that every pixel is screened by a lookup in the tile just like the
+            ordered dither.
+
+            For colour print the image is separated into cyan, magenta, yellow and
+            black, and every separation is screened at its own angle so that the
+            screens do not beat against each other.  Common angles are 15, 75, 0
+            and 45 degrees.  cmykScreen returns the four separations in this order,
+            black pixels mark where ink is printed.
+        */
+        cv::Mat amScreen(const cv::Mat& srcImg, const double angle = defaultScreen.angle, const double lpi = defaultScreen.lpi, const double dpi = defaultDpi) override;
+        std::vector<cv::Mat> cmykScreen(const cv::Mat& srcImg, const double dpi = defaultDpi,
+                                        const Screen cyan = {15., 150.}, const Screen magenta = {75., 150.},
+                                        const Screen yellow = {0., 150.}, const Screen black = {45., 150.}) override;
+
+
+        // the threshold methods and Floyd-Steinberg can be dithered row by row
+        std::unique_ptr<RowDither> rowDither(const METHOD method, const int width) override;
+
+        // every method dithers the grey image it is handed over without a copy
+        cv::Mat applyInPlace(cv::Mat& grayImg, const METHOD method) override;
+
+    protected:
+        // the kernels above run these on a grey copy of their input, each turns
+        // the grey image img into its dither
+        void fixedTresholdInPlace(cv::Mat& img, const uint8_t threshold);
+        void noiseTresholdInPlace(cv::Mat& img, const uint8_t noiseThreshold, const uint8_t threshold);
+        void randomInPlace(cv::Mat& img);
+        void patternedInPlace(cv::Mat& img, const PATTERN_TYPE type);
+        void orderedInPlace(cv::Mat& img, const MAP_TYPE type);
+        void simpleErrorDiffusionInPlace(cv::Mat& img);
+        void floydSteinbergInPlace(cv::Mat& img);
+        void riemersmaInPlace(cv::Mat& img);
+        void ostromoukhovInPlace(cv::Mat& img, const bool serpentine);
+        void blockErrorDiffusionInPlace(cv::Mat& img, const int tileSize);
+        void dotDiffusionInPlace(cv::Mat& img, const CLASS_MATRIX_TYPE type);
+        void amScreenInPlace(cv::Mat& img, const double angle, const double lpi, const double dpi);
     };
 }
 
@@ -0,0 +1,84 @@
+#ifndef DITHER_PIPELINE_HPP
+#define DITHER_PIPELINE_HPP
+
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "Dither.hpp"
+#include "Types.hpp"
+
+
+namespace dither
+{
+    /*  Preprocessing in front of the dithering methods
+
+        Images are usually prepared before dithering: linearized, stretched in
+        contrast, sharpened to survive the halftoning and resized to the device
+        resolution.  Done with one OpenCV call each, the image travels through
+        main memory once per step.
+
+        A Pipeline collects these steps and runs them in a single pass.  All point
+        operations between two neighbourhood operations are folded into one 256
+        entry lookup table, which is applied to the rows the preceding step
+        produces.  Neighbourhood operations only keep the few rows they need
+        in a rolling buffer.  The output is computed in bands of rows which are
+        processed in parallel, so every source pixel is read about once and
+        every output pixel written once.
+
+        apply goes one step further for methods the Dither can run row by row
+        (see Dither::rowDither): the threshold methods dither each band as its
+        last step, Floyd-Steinberg takes the rows in a single band in raster
+        order.  The grey image is then never stored.  All other methods get the
+        preprocessed image handed over and dither it in place.
+
+            dither::Pipeline pipeline;
+            pipeline.gamma(2.2).contrast(10, 245).unsharp(.8).resize(cv::Size(1200, 800));
+            auto dithImg = monochromDither.floydSteinberg(pipeline.process(rawImg));
+    */
+    class Pipeline
+    {
+    public:
+        // out = 255 * (in / 255) ^ gamma, e.g. 2.2 to linearize sRGB like data
+        Pipeline& gamma(const double gamma);
+
+        // maps [low, high] linearly onto [0, 255] and clips the rest
+        Pipeline& contrast(const uint8_t low, const uint8_t high);
+
+        // out = in + amount * (in - blur) with a 3 x 3 Gaussian blur
+        Pipeline& unsharp(const double amount);
+
+        // bilinear resize
+        Pipeline& resize(const cv::Size size);
+
+    public:
+        // converts a BGR or grey image and returns the preprocessed grey image
+        cv::Mat process(const cv::Mat& srcImg) const;
+
+        // preprocesses and dithers with the given method
+        cv::Mat apply(const cv::Mat& srcImg, Dither& dither, const METHOD method) const;
+
+    private:
+        enum STAGE_TYPE
+        {
+            lookup,
+            unsharp_mask,
+            bilinear_resize
+        };
+
+        struct Stage
+        {
+            STAGE_TYPE type;
+            std::vector<uint8_t> lut;
+            double amount;
+            cv::Size size;
+        };
+
+        std::vector<Stage> stages;
+        std::vector<uint8_t>& pointStage();
+        cv::Size outputSize(const cv::Size srcSize) const;
+        cv::Mat run(const cv::Mat& srcImg, Dither::RowDither* rowDither) const;
+    };
+}
+
+
+#endif //DITHER_PIPELINE_HPP
@@ -0,0 +1,90 @@
+#ifndef DITHER_SELECTOR_HPP
+#define DITHER_SELECTOR_HPP
+
+#include <mutex>
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "Dither.hpp"
+#include "Types.hpp"
+
+
+namespace dither
+{
+    /*  Choosing a method by latency budget
+
+        The methods differ by orders of magnitude in cost: a threshold tile lookup
+        runs at hundreds of megapixels per second, a serial error diffusion at a
+        few dozen, and the hardware decides how much the parallel methods gain.
+        A caller with a deadline usually wants the best looking result that is
+        ready in time rather than a fixed method.
+
+        The Selector measures every method of its Dither once on synthetic images
+        of two sizes and models the time as a fixed overhead plus a cost per
+        pixel.  For an image size and a budget it then walks the methods from the
+        highest to the lowest quality and takes the first one predicted to finish
+        in time.  If none does, the fastest method is taken and the choice is
+        marked as over budget.  Methods which fail during the calibration are
+        never chosen.
+
+            dither::Selector selector(monochromDither);
+            dither::Selector::Choice choice;
+            auto dithImg = selector.apply(rawImg, 20., &choice);
+
+        The calibration takes a moment and runs on the first call, or up front
+        with calibrate().  It reflects the thread count OpenCV uses at that time.
+        The measured costs can be read with costs() and handed to a later
+        Selector on the same host with setCosts(), which then skips the
+        calibration.
+    */
+    class Selector
+    {
+    public:
+        struct Choice
+        {
+            METHOD method;
+            double predictedMs;
+            bool withinBudget;
+        };
+
+        // time of a method modelled as overheadMs + pixels * pixelMs
+        struct Cost
+        {
+            METHOD method;
+            double overheadMs;
+            double pixelMs;
+        };
+
+    public:
+        explicit Selector(Dither& dither);
+
+    public:
+        void calibrate();
+
+        // costs of the methods which could be calibrated
+        std::vector<Cost> costs();
+
+        // replaces the calibration, not to be called while other calls run
+        void setCosts(const std::vector<Cost>& costs);
+
+        // predicted time of a method in milliseconds
+        double predict(const METHOD method, const cv::Size size);
+
+        // best method finishing within budgetMs
+        Choice choose(const cv::Size size, const double budgetMs);
+
+        // chooses a method for the image size and dithers with it
+        cv::Mat apply(const cv::Mat& srcImg, const double budgetMs, Choice* choice = nullptr);
+
+    private:
+        const Cost* findCost(const METHOD method) const;
+
+        Dither& dither;
+        std::mutex calibrationMutex;
+        bool calibrated;
+        std::vector<Cost> calibration;
+    };
+}
+
+
+#endif //DITHER_SELECTOR_HPP
@@ -1,6 +1,8 @@
 #ifndef DITHER_TYPES_HPP
 #define DITHER_TYPES_HPP
 
+#include <cstdint>
+
 namespace dither
 {
     enum MAP_TYPE
@@ -17,6 +19,48 @@ namespace dither
         clustered,
         dispersed
     };
+
+    enum METHOD
+    {
+        fixed_threshold,
+        noise_threshold,
+        random_dither,
+        clustered_pattern,
+        dispersed_pattern,
+        ordered_dither,
+        simple_error_diffusion,
+        floyd_steinberg,
+        riemersma_dither,
+        block_error_diffusion,
+        dot_diffusion,
+        am_screen,
+        ostromoukhov_diffusion
+    };
+
+    enum CLASS_MATRIX_TYPE
+    {
+        knuth_8x8,
+        optimized_8x8,
+        optimized_16x16
+    };
+
+    // halftone screen of one separation
+    struct Screen
+    {
+        double angle;   // screen angle in degrees
+        double lpi;     // screen frequency in lines per inch
+    };
+
+    // parameters the methods of METHOD are applied with, also the default
+    // arguments of the corresponding kernels
+    const uint8_t defaultThreshold = 128;
+    const uint8_t defaultNoiseThreshold = 64;
+    const MAP_TYPE defaultMapType = MAP_TYPE::bayer_4x4;
+    const Screen defaultScreen = {45., 85.};
+    const double defaultDpi = 600.;
+    const bool defaultSerpentine = true;
+    const int defaultTileSize = 64;
+    const CLASS_MATRIX_TYPE defaultClassMatrix = CLASS_MATRIX_TYPE::optimized_8x8;
 }
 
 #endif //DITHER_TYPES_HPP
@@ -1,5 +1,27 @@
 #include "Dither.hpp"
 
+#include "opencv2/imgproc/imgproc.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+
+namespace
+{
+    int gcd(int a, int b)
+    {
+        while (b != 0)
+        {
+            const auto t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+}
+
 
 namespace dither
 {
@@ -7,12 +29,62 @@ namespace dither
     {
         createClusteredPatterns();
         createDispersedPatterns();
+        createHilbertCurve();
+        createClassMatrices();
     }
 
 
     Dither::~Dither() {}
 
 
+    cv::Mat Dither::apply(const cv::Mat& srcImg, const METHOD method)
+    {
+        switch (method)
+        {
+            case METHOD::fixed_threshold:
+                return fixedTreshold(srcImg);
+            case METHOD::noise_threshold:
+                return noiseTreshold(srcImg);
+            case METHOD::random_dither:
+                return random(srcImg);
+            case METHOD::clustered_pattern:
+                return patterned(srcImg, PATTERN_TYPE::clustered);
+            case METHOD::dispersed_pattern:
+                return patterned(srcImg, PATTERN_TYPE::dispersed);
+            case METHOD::ordered_dither:
+                return ordered(srcImg);
+            case METHOD::simple_error_diffusion:
+                return simpleErrorDiffusion(srcImg);
+            case METHOD::floyd_steinberg:
+                return floydSteinberg(srcImg);
+            case METHOD::riemersma_dither:
+                return riemersma(srcImg);
+            case METHOD::block_error_diffusion:
+                return blockErrorDiffusion(srcImg);
+            case METHOD::dot_diffusion:
+                return dotDiffusion(srcImg);
+            case METHOD::am_screen:
+                return amScreen(srcImg);
+            case METHOD::ostromoukhov_diffusion:
+                return ostromoukhov(srcImg);
+        }
+        CV_Error(cv::Error::StsBadArg, "unknown dithering method");
+    }
+
+
+    cv::Mat Dither::applyInPlace(cv::Mat& grayImg, const METHOD method)
+    {
+        CV_Assert(grayImg.type() == CV_8UC1);
+        return apply(grayImg, method);
+    }
+
+
+    std::unique_ptr<Dither::RowDither> Dither::rowDither(const METHOD, const int)
+    {
+        return std::unique_ptr<RowDither>();
+    }
+
+
     void Dither::createClusteredPatterns()
     {
         this->clusteredPatterns.clear();
@@ -107,6 +179,194 @@ namespace dither
     }
 
 
+    void Dither::createHilbertCurve()
+    {
+        // One hilbertSize x hilbertSize block of the curve, stored as packed
+        // (y << hilbertOrder | x) offsets in traversal order. The curve starts
+        // at (0,0) and ends at (hilbertSize-1,0), so blocks laid out left to
+        // right join into one continuous path along each block row.
+        const int length = hilbertSize * hilbertSize;
+        this->hilbertCurve.clear();
+        this->hilbertCurve.reserve(length);
+        for (int d = 0; d < length; ++d)
+        {
+            int x = 0;
+            int y = 0;
+            int t = d;
+            for (int s = 1; s < hilbertSize; s *= 2)
+            {
+                const int rx = 1 & (t / 2);
+                const int ry = 1 & (t ^ rx);
+                if (ry == 0)
+                {
+                    if (rx == 1)
+                    {
+                        x = s - 1 - x;
+                        y = s - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+                x += s * rx;
+                y += s * ry;
+                t /= 4;
+            }
+            this->hilbertCurve.push_back((uint16_t)((y << hilbertOrder) | x));
+        }
+    }
+
+
+    void Dither::createClassMatrices()
+    {
+        // order in which the pixels of a tile are processed by the dot diffusion,
+        // indexed by CLASS_MATRIX_TYPE
+        this->classMatrices.clear();
+        this->classMatrices.reserve(3);
+
+        // Knuth, "Digital halftones by dot diffusion", 1987
+        this->classMatrices.push_back((cv::Mat_<uint8_t>(8,8)
+                <<  34, 48, 40, 32, 29, 15, 23, 31,
+                    42, 58, 56, 53, 21,  5,  7, 10,
+                    50, 62, 61, 45, 13,  1,  2, 18,
+                    38, 46, 54, 37, 25, 17,  9, 26,
+                    28, 14, 22, 30, 35, 49, 41, 33,
+                    20,  4,  6, 11, 43, 59, 57, 52,
+                    12,  0,  3, 19, 51, 63, 60, 44,
+                    24, 16,  8, 27, 39, 47, 55, 36));
+
+        // Both optimized matrices follow the approach of Mese and Vaidyanathan:
+        // starting from Knuth's matrix (for 16x16 four copies of it, ranked like the
+        // quadrants of a 2x2 Bayer map) pairs of classes were swapped as long as the swap
+        // lowered the squared error between the input and the Gaussian (sigma 1.5)
+        // filtered dot diffusion of flat patches at 8 grey levels.  The search does
+        // not avoid barons: the optimized 8x8 matrix has 3 instead of 2, the 16x16
+        // one 15 instead of the 8 of four Knuth tiles, yet both lower the filtered
+        // error to less than half (see tests/class_matrices.cpp).
+        this->classMatrices.push_back((cv::Mat_<uint8_t>(8,8)
+                <<  50,  3, 49, 51, 29, 15, 23, 31,
+                    32, 58, 56, 55, 41,  5,  7, 48,
+                    53, 33, 61, 10, 13, 63,  2, 18,
+                    21, 46, 54, 59, 25,  1,  9, 26,
+                    28, 14, 22, 30, 35, 44, 45, 40,
+                    20,  4, 17,  6, 37, 62, 42, 12,
+                    38,  0, 11, 19, 57, 43, 60, 52,
+                    24, 16,  8, 27, 39, 47, 34, 36));
+        this->classMatrices.push_back((cv::Mat_<uint8_t>(16,16)
+                <<   53, 239, 249, 180,  84,  66, 145,  35, 114, 194, 222, 130,  91, 205,  65,  40,
+                    226, 232,  71, 158, 141, 159, 160,  62, 248, 224,  28, 214,  86,  22,  30,  20,
+                    200, 189, 216, 209,  52,   4,  44,  72, 202, 250, 161, 182,  54,   6,  10,  50,
+                    152, 184, 192, 128, 100,  68,  36, 136, 170, 104, 176, 150, 148, 121,  38, 134,
+                    124, 112,  88, 178, 231, 252, 143, 120, 138,  58,  59,  93, 142, 198, 212, 139,
+                    111,  16, 102,   8, 172,  56, 228, 236,  82,  60, 223,  70, 208,  26, 230, 210,
+                    233,   0,  12,  76, 235, 166, 240, 151,  74,   2,  14,  78, 206, 254, 154, 221,
+                    234,  46,  32, 108, 156, 188, 220, 144,  98,  18,  34, 110, 126, 190, 246,  96,
+                    106, 195, 103, 131, 119,  87, 196, 127, 181, 225, 238, 165, 117,  61, 122, 146,
+                    171,  42, 227, 179,  63,  23, 125,  43,  31, 215, 193, 213,  85,  21,  29,  41,
+                    183,  24, 247, 175,  55,   7,  11,  75, 201, 169, 245, 203, 244,   5,   9,  73,
+                    155, 187,  95, 218, 163,  48,  39, 107, 153, 185, 217, 149, 219, 168,  37, 105,
+                    115,  64, 118, 137, 164, 199, 167, 135, 113,  57,  89,  90,  94, 197, 129, 133,
+                     83,  19,  27, 123,  69, 162, 204, 211,  81,  17,  25,  45, 173, 237, 229, 186,
+                     51,  47,  15,  79, 207, 255, 243, 242,  49,   1,  13,  77,  92, 132, 241, 177,
+                     99,  67,   3,  80, 251, 191, 174, 147,  97, 140,  33, 109, 157, 101, 253, 116));
+    }
+
+
+    cv::Mat Dither::screenTile(const double angle, const double lpi, const double dpi)
+    {
+        CV_Assert(lpi > 0. && dpi >= 2. * lpi);
+        const auto key = std::make_tuple(angle, lpi, dpi);
+        {
+            // the tile is computed without the lock, so the separations of a
+            // colour screen do not wait for each other on first use
+            std::lock_guard<std::mutex> lock(this->screenTilesMutex);
+            const auto cached = this->screenTiles.find(key);
+            if (cached != this->screenTiles.end())
+            {
+                return cached->second;
+            }
+        }
+
+        // A screen whose cell vector (a,b) has integer coordinates repeats every
+        // (a*a+b*b)/gcd(a,b) pixels in x and y.  Rounding the cell vector of a
+        // few pixels directly would distort angle and frequency, so the vector
+        // (A,B) of a super-cell of k x k cells is rounded instead and the k with
+        // the smallest deviation whose tile stays small enough is used.
+        const int maxTileSize = 256;
+        const auto period = dpi / lpi;
+        const auto theta = angle * CV_PI / 180.;
+        int bestA = 0, bestB = 0, bestK = 0, tileSize = 0;
+        auto bestDeviation = 0.;
+        for (int k = 1; k <= 16; ++k)
+        {
+            const auto a = (int)std::lround(k * period * std::cos(theta));
+            const auto b = (int)std::lround(k * period * std::sin(theta));
+            const auto length2 = a * a + b * b;
+            if (length2 == 0)
+            {
+                continue;
+            }
+            const auto size = length2 / gcd(length2, gcd(std::abs(k * a), std::abs(k * b)));
+            if (size > maxTileSize)
+            {
+                continue;
+            }
+            auto angleDeviation = std::abs(std::atan2((double)b, (double)a) - theta) * 180. / CV_PI;
+            angleDeviation = std::min(angleDeviation, 360. - angleDeviation);
+            const auto periodDeviation = std::abs(std::sqrt((double)length2) / k - period) / period;
+            // one degree of angle counts as much as one percent of frequency
+            const auto deviation = std::max(angleDeviation, periodDeviation * 100.);
+            if (bestK == 0 || deviation < bestDeviation - 1e-9)
+            {
+                bestA = a;
+                bestB = b;
+                bestK = k;
+                tileSize = size;
+                bestDeviation = deviation;
+            }
+        }
+        CV_Assert(bestK > 0);
+
+        // round dot spot function in screen coordinates (u,v), highest at the
+        // dot centres where the dots start to grow
+        const auto length2 = (double)(bestA * bestA + bestB * bestB);
+        const auto pixels = tileSize * tileSize;
+        std::vector<double> spot(pixels);
+        for (int y = 0; y < tileSize; ++y)
+        {
+            for (int x = 0; x < tileSize; ++x)
+            {
+                const auto u = (x * bestA + y * bestB) * bestK / length2;
+                const auto v = (y * bestA - x * bestB) * bestK / length2;
+                spot[y * tileSize + x] = std::cos(2. * CV_PI * u) + std::cos(2. * CV_PI * v);
+            }
+        }
+
+        // rank all pixels of the tile so that every grey level blackens the
+        // corresponding fraction of the tile, like the ordered dither maps
+        std::vector<int> order(pixels);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](const int i, const int j) { return spot[i] > spot[j]; });
+        cv::Mat tile(tileSize, tileSize, CV_8UC1);
+        for (int rank = 0; rank < pixels; ++rank)
+        {
+            tile.at<uint8_t>(order[rank] / tileSize, order[rank] % tileSize) = (uint8_t)(255 - rank * 255 / pixels);
+        }
+
+        // a thread computing the same screen at the same time may have stored
+        // it already; once the cache is full further screens are not kept
+        std::lock_guard<std::mutex> lock(this->screenTilesMutex);
+        const auto cached = this->screenTiles.find(key);
+        if (cached != this->screenTiles.end())
+        {
+            return cached->second;
+        }
+        if (this->screenTiles.size() < maxScreenTiles)
+        {
+            this->screenTiles.emplace(key, tile);
+        }
+        return tile;
+    }
+
+
     uint8_t Dither::saturated_add(uint8_t val1, int8_t val2)
     {
         int16_t val1_int = val1;
@@ -125,4 +385,18 @@ namespace dither
             return tmp;
         }
     }
+
+
+    void Dither::toGray(const cv::Mat& srcImg, cv::Mat& grayImg)
+    {
+        // the kernels dither the grey image in place, so a grey input is copied
+        if (srcImg.channels() == 1)
+        {
+            srcImg.copyTo(grayImg);
+        }
+        else
+        {
+            cv::cvtColor(srcImg, grayImg, cv::COLOR_BGR2GRAY);
+        }
+    }
 }
@@ -2,73 +2,312 @@
 
 #include "opencv2/imgproc/imgproc.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <random>
 
 
-namespace dither
+namespace
 {
-    cv::Mat MonochromDither::fixedTreshold(const cv::Mat& srcImg, const uint8_t threshold)
+    // Ostromoukhov's error weights to the right, down-left and down neighbour
+    // and their sum for the input levels 0 - 127, levels 128 - 255 mirror them
+    const int ostromoukhovCoefs[128][4] =
     {
-        const auto imgWidth = srcImg.cols;
-        const auto imgHeight = srcImg.rows;
-        cv::Mat dithImg;
-        cv::cvtColor(srcImg, dithImg, cv::COLOR_BGR2GRAY);
-        for (int y = 0; y < imgHeight; ++y)
+        {  13,    0,    5,   18}, {  13,    0,    5,   18}, {  21,    0,   10,   31}, {   7,    0,    4,   11},   //   0 -   3
+        {   8,    0,    5,   13}, {  47,    3,   28,   78}, {  23,    3,   13,   39}, {  15,    3,    8,   26},   //   4 -   7
+        {  22,    6,   11,   39}, {  43,   15,   20,   78}, {   7,    3,    3,   13}, { 501,  224,  211,  936},   //   8 -  11
+        { 249,  116,  103,  468}, { 165,   80,   67,  312}, { 123,   62,   49,  234}, { 489,  256,  191,  936},   //  12 -  15
+        {  81,   44,   31,  156}, { 483,  272,  181,  936}, {  60,   35,   22,  117}, {  53,   32,   19,  104},   //  16 -  19
+        { 237,  148,   83,  468}, { 471,  304,  161,  936}, {   3,    2,    1,    6}, { 481,  314,  185,  980},   //  20 -  23
+        { 354,  226,  155,  735}, {1389,  866,  685, 2940}, { 227,  138,  125,  490}, { 267,  158,  163,  588},   //  24 -  27
+        { 327,  188,  220,  735}, {  61,   34,   45,  140}, { 627,  338,  505, 1470}, {1227,  638, 1075, 2940},   //  28 -  31
+        {  20,   10,   19,   49}, {1937, 1000, 1767, 4704}, { 977,  520,  855, 2352}, { 657,  360,  551, 1568},   //  32 -  35
+        {  71,   40,   57,  168}, {2005, 1160, 1539, 4704}, { 337,  200,  247,  784}, {2039, 1240, 1425, 4704},   //  36 -  39
+        { 257,  160,  171,  588}, { 691,  440,  437, 1568}, {1045,  680,  627, 2352}, { 301,  200,  171,  672},   //  40 -  43
+        { 177,  120,   95,  392}, {2141, 1480, 1083, 4704}, {1079,  760,  513, 2352}, { 725,  520,  323, 1568},   //  44 -  47
+        { 137,  100,   57,  294}, {2209, 1640,  855, 4704}, {  53,   40,   19,  112}, {2243, 1720,  741, 4704},   //  48 -  51
+        { 565,  440,  171, 1176}, { 759,  600,  209, 1568}, {1147,  920,  285, 2352}, {2311, 1880,  513, 4704},   //  52 -  55
+        {  97,   80,   19,  196}, { 335,  280,   57,  672}, {1181, 1000,  171, 2352}, { 793,  680,   95, 1568},   //  56 -  59
+        { 599,  520,   57, 1176}, {2413, 2120,  171, 4704}, { 405,  360,   19,  784}, {2447, 2200,   57, 4704},   //  60 -  63
+        {  11,   10,    0,   21}, { 158,  151,    3,  312}, { 178,  179,    7,  364}, {1030, 1091,   63, 2184},   //  64 -  67
+        { 248,  277,   21,  546}, { 318,  375,   35,  728}, { 458,  571,   63, 1092}, { 878, 1159,  147, 2184},   //  68 -  71
+        {   5,    7,    1,   13}, { 172,  181,   37,  390}, {  97,   76,   22,  195}, {  72,   41,   17,  130},   //  72 -  75
+        { 119,   47,   29,  195}, {   4,    1,    1,    6}, {   4,    1,    1,    6}, {   4,    1,    1,    6},   //  76 -  79
+        {   4,    1,    1,    6}, {   4,    1,    1,    6}, {   4,    1,    1,    6}, {   4,    1,    1,    6},   //  80 -  83
+        {   4,    1,    1,    6}, {   4,    1,    1,    6}, {  65,   18,   17,  100}, {  95,   29,   26,  150},   //  84 -  87
+        { 185,   62,   53,  300}, {  30,   11,    9,   50}, {  35,   14,   11,   60}, {  85,   37,   28,  150},   //  88 -  91
+        {  55,   26,   19,  100}, {  80,   41,   29,  150}, { 155,   86,   59,  300}, {   5,    3,    2,   10},   //  92 -  95
+        {   5,    3,    2,   10}, {   5,    3,    2,   10}, {   5,    3,    2,   10}, {   5,    3,    2,   10},   //  96 -  99
+        {   5,    3,    2,   10}, {   5,    3,    2,   10}, {   5,    3,    2,   10}, {   5,    3,    2,   10},   // 100 - 103
+        {   5,    3,    2,   10}, {   5,    3,    2,   10}, {   5,    3,    2,   10}, {   5,    3,    2,   10},   // 104 - 107
+        { 305,  176,  119,  600}, { 155,   86,   59,  300}, { 105,   56,   39,  200}, {  80,   41,   29,  150},   // 108 - 111
+        {  65,   32,   23,  120}, {  55,   26,   19,  100}, { 335,  152,  113,  600}, {  85,   37,   28,  150},   // 112 - 115
+        { 115,   48,   37,  200}, {  35,   14,   11,   60}, { 355,  136,  109,  600}, {  30,   11,    9,   50},   // 116 - 119
+        { 365,  128,  107,  600}, { 185,   62,   53,  300}, {  25,    8,    7,   40}, {  95,   29,   26,  150},   // 120 - 123
+        { 385,  112,  103,  600}, {  65,   18,   17,  100}, { 395,  104,  101,  600}, {   4,    1,    1,    6}    // 124 - 127
+    };
+
+
+    // Fixed threshold, ordered dither and screens compare every pixel with a
+    // threshold tile repeated over the image. Rows are independent, so they can
+    // be dithered in any order.
+    class ThresholdRows : public dither::Dither::RowDither
+    {
+    public:
+        explicit ThresholdRows(const cv::Mat& tile, const int width) : tile(tile), width(width) {}
+
+        bool parallel() const override
         {
-            for (int x = 0; x < imgWidth; ++x)
+            return true;
+        }
+
+        void push(const int y, const uint8_t* grayRow, uint8_t* dithRow) override
+        {
+            const auto tileWidth = tile.cols;
+            const auto tileRow = tile.ptr<uint8_t>(y % tile.rows);
+            for (int x = 0, tileX = 0; x < width; ++x)
+            {
+                dithRow[x] = (grayRow[x] < tileRow[tileX]) ? 0 : 255;
+                if (++tileX == tileWidth)
+                {
+                    tileX = 0;
+                }
+            }
+        }
+
+    private:
+        const cv::Mat tile;
+        const int width;
+    };
+
+
+    // Floyd-Steinberg on the rows of a uint8 image, with the saturation of the
+    // whole image kernel. A row is finished when the next one has been pushed
+    // and received its share of the error.
+    class FloydSteinbergRows : public dither::Dither::RowDither
+    {
+    public:
+        explicit FloydSteinbergRows(const int width)
+            : width(width), buffer(2 * width), curRow(buffer.data()), nextRow(buffer.data() + width), pendingRow(nullptr) {}
+
+        bool parallel() const override
+        {
+            return false;
+        }
+
+        void push(const int, const uint8_t* grayRow, uint8_t* dithRow) override
+        {
+            std::copy(grayRow, grayRow + width, nextRow);
+            if (pendingRow != nullptr)
             {
-                auto pxlVal = dithImg.at<uint8_t>(y,x);
-                dithImg.at<uint8_t>(y,x) = (pxlVal < threshold) ? 0 : 255;
+                diffuse(true);
             }
+            std::swap(curRow, nextRow);
+            pendingRow = dithRow;
         }
+
+        void finish() override
+        {
+            // the last row passes on no error at all
+            if (pendingRow != nullptr)
+            {
+                diffuse(false);
+                pendingRow = nullptr;
+            }
+        }
+
+    private:
+        void diffuse(const bool hasNextRow)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const uint8_t oldPxlVal = curRow[x];
+                const uint8_t newPxlVal = (oldPxlVal < 127) ? 0 : 255;
+                pendingRow[x] = newPxlVal;
+                const int8_t err = oldPxlVal - newPxlVal;
+                if (hasNextRow && (x != 0) && (x != (width-1)))
+                {
+                    curRow[x+1]  = cv::saturate_cast<uint8_t>(curRow[x+1]  + (int8_t)((err * 7) / 16));
+                    nextRow[x+1] = cv::saturate_cast<uint8_t>(nextRow[x+1] + (int8_t)((err * 1) / 16));
+                    nextRow[x+0] = cv::saturate_cast<uint8_t>(nextRow[x+0] + (int8_t)((err * 5) / 16));
+                    nextRow[x-1] = cv::saturate_cast<uint8_t>(nextRow[x-1] + (int8_t)((err * 3) / 16));
+                }
+            }
+        }
+
+        const int width;
+        std::vector<uint8_t> buffer;
+        uint8_t* curRow;
+        uint8_t* nextRow;
+        uint8_t* pendingRow;
+    };
+
+
+    void ditherRows(dither::Dither::RowDither& rows, const cv::Mat& grayImg, cv::Mat& dithImg)
+    {
+        dithImg.create(grayImg.size(), CV_8UC1);
+        for (int y = 0; y < grayImg.rows; ++y)
+        {
+            rows.push(y, grayImg.ptr<uint8_t>(y), dithImg.ptr<uint8_t>(y));
+        }
+        rows.finish();
+    }
+
+
+    // ordered dither maps as thresholds on the grey value: a pixel is white if
+    // (pxlVal / 255) * mapSize^2 reaches its map entry
+    cv::Mat orderedThresholds(const dither::MAP_TYPE type)
+    {
+        cv::Mat thMap;
+        uint8_t thMapW;
+
+        switch (type)
+        {
+            case dither::MAP_TYPE::bayer_2x2:
+                thMapW = 2;
+                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
+                    <<  1, 3,
+                        4, 2);
+            break;
+            case dither::MAP_TYPE::bayer_4x4:
+                thMapW = 4;
+                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
+                    <<   1,  9,  3, 11,
+                        13,  5, 15,  7,
+                         4, 12,  2, 10,
+                        16,  8, 14,  6);
+            break;
+            case dither::MAP_TYPE::bayer_8x8:
+                thMapW = 8;
+                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
+                    <<   0, 32,  8, 40,  2, 34, 10, 42,
+                        48, 16, 56, 24, 50, 18, 58, 26,
+                        12, 44,  4, 36, 14, 46,  6, 38,
+                        60, 28, 52, 20, 62, 30, 54, 22,
+                         3, 35, 11, 43,  1, 33,  9, 41,
+                        51, 19, 59, 27, 49, 17, 57, 25,
+                        15, 47,  7, 39, 13, 45,  5, 37,
+                        63, 31, 55, 23, 61, 29, 53, 21);
+            case dither::MAP_TYPE::clustered_3x3_1:
+                thMapW = 3;
+                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
+                    <<  8, 3, 4,
+                        6, 1, 2,
+                        7, 5, 9);
+            break;
+            case dither::MAP_TYPE::clustered_3x3_2:
+                thMapW = 3;
+                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
+                    <<  1, 7, 4,
+                        5, 8, 3,
+                        6, 2, 9);
+            break;
+        }
+        const auto thMapW2 = thMapW * thMapW;
+        cv::Mat thresholds(thMapW, thMapW, CV_8UC1);
+        for (int y = 0; y < thMapW; ++y)
+        {
+            for (int x = 0; x < thMapW; ++x)
+            {
+                int threshold = 0;
+                while ((threshold < 255) && ((uint8_t)((threshold/255.f) * thMapW2) < thMap.at<uint8_t>(y,x)))
+                {
+                    ++threshold;
+                }
+                thresholds.at<uint8_t>(y,x) = (uint8_t)threshold;
+            }
+        }
+        return thresholds;
+    }
+}
+
+
+namespace dither
+{
+    cv::Mat MonochromDither::fixedTreshold(const cv::Mat& srcImg, const uint8_t threshold)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        fixedTresholdInPlace(dithImg, threshold);
         return dithImg;
     }
 
 
+    void MonochromDither::fixedTresholdInPlace(cv::Mat& img, const uint8_t threshold)
+    {
+        ThresholdRows rows(cv::Mat(1, 1, CV_8UC1, cv::Scalar::all(threshold)), img.cols);
+        ditherRows(rows, img, img);
+    }
+
+
     cv::Mat MonochromDither::noiseTreshold(const cv::Mat& srcImg, const uint8_t noiseThreshold, const uint8_t threshold)
     {
-        const auto imgWidth = srcImg.cols;
-        const auto imgHeight = srcImg.rows;
         cv::Mat dithImg;
-        cv::cvtColor(srcImg, dithImg, cv::COLOR_BGR2GRAY);
+        toGray(srcImg, dithImg);
+        noiseTresholdInPlace(dithImg, noiseThreshold, threshold);
+        return dithImg;
+    }
+
+
+    void MonochromDither::noiseTresholdInPlace(cv::Mat& img, const uint8_t noiseThreshold, const uint8_t threshold)
+    {
+        const auto imgWidth = img.cols;
+        const auto imgHeight = img.rows;
         const auto offset = (int)(noiseThreshold/2);
-        const auto noise = cv::Mat(srcImg.size(), CV_8SC1);
+        const auto noise = cv::Mat(img.size(), CV_8SC1);
         cv::randu(noise, cv::Scalar::all(-offset), cv::Scalar::all(offset+1));
-        noise += dithImg;
+        // the sum of an unsigned and a signed image needs a wider type
+        cv::Mat noisyImg;
+        cv::add(img, noise, noisyImg, cv::noArray(), CV_16S);
         for (int y = 0; y < imgHeight; ++y)
         {
             for (int x = 0; x < imgWidth; ++x)
             {
-                auto pxlVal = noise.at<int8_t>(y,x);
-                dithImg.at<uint8_t>(y,x) = (pxlVal < threshold) ? 0 : 255;
+                auto pxlVal = noisyImg.at<int16_t>(y,x);
+                img.at<uint8_t>(y,x) = (pxlVal < threshold) ? 0 : 255;
             }
         }
-        return dithImg;
     }
 
 
     cv::Mat MonochromDither::random(const cv::Mat& srcImg)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        randomInPlace(dithImg);
+        return dithImg;
+    }
+
+
+    void MonochromDither::randomInPlace(cv::Mat& img)
     {
         std::random_device rd;
         std::mt19937 generator(rd());
         std::uniform_int_distribution<uint8_t> random(0, 255);
-        const auto imgWidth = srcImg.cols;
-        const auto imgHeight = srcImg.rows;
-        cv::Mat dithImg;
-        cv::cvtColor(srcImg, dithImg, cv::COLOR_BGR2GRAY);
+        const auto imgWidth = img.cols;
+        const auto imgHeight = img.rows;
         for (int y = 0; y < imgHeight; ++y)
         {
             for (int x = 0; x < imgWidth; ++x)
             {
-                auto pxlVal = dithImg.at<uint8_t>(y,x);
-                dithImg.at<uint8_t>(y,x) = (pxlVal < random(generator)) ? 0 : 255;
+                auto pxlVal = img.at<uint8_t>(y,x);
+                img.at<uint8_t>(y,x) = (pxlVal < random(generator)) ? 0 : 255;
             }
         }
-        return dithImg;
     }
 
 
     cv::Mat MonochromDither::patterned(const cv::Mat& srcImg, const dither::PATTERN_TYPE type)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        patternedInPlace(dithImg, type);
+        return dithImg;
+    }
+
+
+    void MonochromDither::patternedInPlace(cv::Mat& img, const dither::PATTERN_TYPE type)
     {
         auto patterns = &this->dispersedPatterns;
         switch (type)
@@ -86,15 +325,13 @@ namespace dither
                 patterns = &this->dispersedPatterns;
                 break;
         }
-        const auto imgWidth = srcImg.cols - 1;
-        const auto imgHeight = srcImg.rows - 1;
-        cv::Mat dithImg;
-        cv::cvtColor(srcImg, dithImg, cv::COLOR_BGR2GRAY);
+        const auto imgWidth = img.cols - 1;
+        const auto imgHeight = img.rows - 1;
         for (int y = 1; y < imgHeight; y+=2)
         {
             for (int x = 1; x < imgWidth; x+=2)
             {
-                cv::Mat aux = dithImg.colRange(x-1,x+2).rowRange(y-1,y+2);
+                cv::Mat aux = img.colRange(x-1,x+2).rowRange(y-1,y+2);
                 auto mean = (uint8_t)cv::mean(aux)[0];
                 if      (mean <= 25)  { patterns->at(0).copyTo(aux); }
                 else if (mean <= 50)  { patterns->at(1).copyTo(aux); }
@@ -108,124 +345,479 @@ namespace dither
                 else                  { patterns->at(9).copyTo(aux); }
             }
         }
-        return dithImg;
     }
 
 
     cv::Mat MonochromDither::ordered(const cv::Mat& srcImg, const dither::MAP_TYPE type)
     {
-        const auto imgWidth = srcImg.cols;
-        const auto imgHeight = srcImg.rows;
         cv::Mat dithImg;
-        cv::cvtColor(srcImg, dithImg, cv::COLOR_BGR2GRAY);
+        toGray(srcImg, dithImg);
+        orderedInPlace(dithImg, type);
+        return dithImg;
+    }
 
-        cv::Mat thMap;
-        uint8_t thMapW;
 
-        switch (type)
-        {
-            case dither::MAP_TYPE::bayer_2x2:
-                thMapW = 2;
-                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
-                    <<  1, 3,
-                        4, 2);
-            break;
-            case dither::MAP_TYPE::bayer_4x4:
-                thMapW = 4;
-                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
-                    <<   1,  9,  3, 11,
-                        13,  5, 15,  7,
-                         4, 12,  2, 10,
-                        16,  8, 14,  6);
-            break;
-            case dither::MAP_TYPE::bayer_8x8:
-                thMapW = 8;
-                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
-                    <<   0, 32,  8, 40,  2, 34, 10, 42,
-                        48, 16, 56, 24, 50, 18, 58, 26,
-                        12, 44,  4, 36, 14, 46,  6, 38,
-                        60, 28, 52, 20, 62, 30, 54, 22,
-                         3, 35, 11, 43,  1, 33,  9, 41,
-                        51, 19, 59, 27, 49, 17, 57, 25,
-                        15, 47,  7, 39, 13, 45,  5, 37,
-                        63, 31, 55, 23, 61, 29, 53, 21);
-            case dither::MAP_TYPE::clustered_3x3_1:
-                thMapW = 3;
-                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
-                    <<  8, 3, 4,
-                        6, 1, 2,
-                        7, 5, 9);
-            break;
-            case dither::MAP_TYPE::clustered_3x3_2:
-                thMapW = 3;
-                thMap = (cv::Mat_<uint8_t>(thMapW, thMapW)
-                    <<  1, 7, 4,
-                        5, 8, 3,
-                        6, 2, 9);
-            break;
-        }
-        const auto thMapW2 = thMapW * thMapW;
+    void MonochromDither::orderedInPlace(cv::Mat& img, const dither::MAP_TYPE type)
+    {
+        ThresholdRows rows(orderedThresholds(type), img.cols);
+        ditherRows(rows, img, img);
+    }
+
+
+    cv::Mat MonochromDither::simpleErrorDiffusion(const cv::Mat& srcImg)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        simpleErrorDiffusionInPlace(dithImg);
+        return dithImg;
+    }
+
+
+    void MonochromDither::simpleErrorDiffusionInPlace(cv::Mat& img)
+    {
+        const auto imgWidth = img.cols;
+        const auto imgHeight = img.rows;
         for (int y = 0; y < imgHeight; ++y)
         {
+            int8_t err = 0;
             for (int x = 0; x < imgWidth; ++x)
             {
-                auto thMapY = y % thMapW;
-                auto thMapX = x % thMapW;
-                auto pxlVal = (uint8_t)((dithImg.at<uint8_t>(y,x)/255.f) * thMapW2);
-                dithImg.at<uint8_t>(y,x) = (pxlVal < thMap.at<uint8_t>(thMapY,thMapX)) ? 0 : 255;
+                auto pxlVal = img.at<uint8_t>(y,x);
+                if (x != imgWidth-1)
+                {
+                    err = (pxlVal < 127) ? pxlVal : pxlVal-255;
+                    img.at<uint8_t>(y,x+1) = saturated_add(img.at<uint8_t>(y,x+1), err);
+                }
+                img.at<uint8_t>(y,x) = (pxlVal < 127) ? 0 : 255;
             }
         }
+    }
+
+
+    cv::Mat MonochromDither::floydSteinberg(const cv::Mat &srcImg)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        floydSteinbergInPlace(dithImg);
         return dithImg;
     }
 
 
-    cv::Mat MonochromDither::simpleErrorDiffusion(const cv::Mat& srcImg)
+    void MonochromDither::floydSteinbergInPlace(cv::Mat& img)
+    {
+        FloydSteinbergRows rows(img.cols);
+        ditherRows(rows, img, img);
+    }
+
+
+    cv::Mat MonochromDither::riemersma(const cv::Mat& srcImg)
     {
-        const auto imgWidth = srcImg.cols;
-        const auto imgHeight = srcImg.rows;
         cv::Mat dithImg;
-        cv::cvtColor(srcImg, dithImg, cv::COLOR_BGR2GRAY);
-        for (int y = 0; y < imgHeight; ++y)
+        toGray(srcImg, dithImg);
+        riemersmaInPlace(dithImg);
+        return dithImg;
+    }
+
+
+    void MonochromDither::riemersmaInPlace(cv::Mat& img)
+    {
+        const auto imgWidth = img.cols;
+        const auto imgHeight = img.rows;
+
+        // queue of the last errors along the curve, weights[0] is applied to the
+        // oldest and weights[queueSize-1] to the newest entry
+        const int queueSize = 16;
+        const int maxWeight = 16;
+        int weights[queueSize];
+        const auto ratio = std::exp(std::log((double)maxWeight) / (queueSize - 1));
+        auto weight = 1.;
+        for (int i = 0; i < queueSize; ++i)
         {
-            int8_t err = 0;
-            for (int x = 0; x < imgWidth; ++x)
+            weights[i] = (int)(weight + .5);
+            weight *= ratio;
+        }
+        int errors[queueSize] = {0};
+        int oldest = 0;
+        int prevX = -1;
+        int prevY = 0;
+
+        const auto blockMask = hilbertSize - 1;
+        for (int blockY = 0; blockY < imgHeight; blockY += hilbertSize)
+        {
+            for (int blockX = 0; blockX < imgWidth; blockX += hilbertSize)
             {
-                auto pxlVal = dithImg.at<uint8_t>(y,x);
-                if (x != imgWidth-1)
+                for (const auto offset : this->hilbertCurve)
                 {
-                    err = (pxlVal < 127) ? pxlVal : pxlVal-255;
-                    dithImg.at<uint8_t>(y,x+1) = saturated_add(dithImg.at<uint8_t>(y,x+1), err);
+                    const int x = blockX + (offset & blockMask);
+                    const int y = blockY + (offset >> hilbertOrder);
+                    if ((x >= imgWidth) || (y >= imgHeight))
+                    {
+                        continue;
+                    }
+                    // the walk jumps where a clipped block leaves the image and
+                    // from one block row to the next, the queued errors belong
+                    // to pixels far away and are dropped there
+                    if (std::abs(x - prevX) + std::abs(y - prevY) != 1)
+                    {
+                        std::fill(errors, errors + queueSize, 0);
+                    }
+                    prevX = x;
+                    prevY = y;
+                    int err = 0;
+                    for (int i = 0; i < queueSize; ++i)
+                    {
+                        err += errors[(oldest + i) & (queueSize - 1)] * weights[i];
+                    }
+                    auto pxl = img.ptr<uint8_t>(y) + x;
+                    const int oldPxlVal = *pxl;
+                    const uint8_t newPxlVal = ((oldPxlVal + err / maxWeight) < 128) ? 0 : 255;
+                    errors[oldest] = oldPxlVal - newPxlVal;
+                    oldest = (oldest + 1) & (queueSize - 1);
+                    *pxl = newPxlVal;
                 }
-                dithImg.at<uint8_t>(y,x) = (pxlVal < 127) ? 0 : 255;
             }
         }
+    }
+
+
+    cv::Mat MonochromDither::blockErrorDiffusion(const cv::Mat& srcImg, const int tileSize)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        blockErrorDiffusionInPlace(dithImg, tileSize);
         return dithImg;
     }
 
 
-    cv::Mat MonochromDither::floydSteinberg(const cv::Mat &srcImg)
+    void MonochromDither::blockErrorDiffusionInPlace(cv::Mat& img, const int tileSize)
+    {
+        CV_Assert(tileSize >= 2);
+        const auto imgWidth = img.cols;
+        const auto imgHeight = img.rows;
+
+        // diffused error of every pixel in 1/16, padded by a row below and a
+        // column on each side which swallow the error leaving the image
+        const auto errStride = imgWidth + 2;
+        std::vector<int> errBuffer((imgHeight + 1) * errStride, 0);
+
+        // tile (tileY, tileX) covers the columns [tileX * tileSize - i,
+        // (tileX + 1) * tileSize - i) in its i-th row, the first and the last tile
+        // of a row extend to the image border.  Leaning one pixel to the left per
+        // row, a tile only receives error from the tile on its left and the two
+        // tiles above and above right.  Step 3 * tileY + tileX runs after all of
+        // them, and the tiles of a step are far enough apart to never touch the
+        // same error.
+        const auto tilesX = (imgWidth + tileSize - 1) / tileSize;
+        const auto tilesY = (imgHeight + tileSize - 1) / tileSize;
+        const auto steps = 3 * (tilesY - 1) + tilesX;
+        for (int step = 0; step < steps; ++step)
+        {
+            const auto firstTileY = std::max(step - tilesX + 3, 0) / 3;
+            const auto lastTileY = std::min(step / 3, tilesY - 1);
+            cv::parallel_for_(cv::Range(firstTileY, lastTileY + 1), [&](const cv::Range& range)
+            {
+                for (int tileY = range.start; tileY < range.end; ++tileY)
+                {
+                    const auto tileX = step - 3 * tileY;
+                    const auto tileEndY = std::min((tileY + 1) * tileSize, imgHeight);
+                    for (int y = tileY * tileSize; y < tileEndY; ++y)
+                    {
+                        const auto shift = y - tileY * tileSize;
+                        const auto startX = (tileX == 0) ? 0 : tileX * tileSize - shift;
+                        const auto endX = (tileX == tilesX - 1) ? imgWidth : (tileX + 1) * tileSize - shift;
+                        // a pixel is read right before it is overwritten
+                        const auto row = img.ptr<uint8_t>(y);
+                        const auto errCur = errBuffer.data() + y * errStride + 1;
+                        const auto errNext = errCur + errStride;
+                        for (int x = startX; x < endX; ++x)
+                        {
+                            const int oldPxlVal = row[x] + errCur[x] / 16;
+                            const int newPxlVal = (oldPxlVal < 128) ? 0 : 255;
+                            const int err = oldPxlVal - newPxlVal;
+                            errCur[x+1]  += err * 7;
+                            errNext[x-1] += err * 3;
+                            errNext[x+0] += err * 5;
+                            errNext[x+1] += err * 1;
+                            row[x] = (uint8_t)newPxlVal;
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+
+    cv::Mat MonochromDither::dotDiffusion(const cv::Mat& srcImg, const dither::CLASS_MATRIX_TYPE type)
     {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        dotDiffusionInPlace(dithImg, type);
+        return dithImg;
+    }
+
+
+    void MonochromDither::dotDiffusionInPlace(cv::Mat& img, const dither::CLASS_MATRIX_TYPE type)
+    {
+        const auto imgWidth = img.cols;
+        const auto imgHeight = img.rows;
+
+        // pixel values plus the diffused error in 1/256
+        cv::Mat valImg;
+        img.convertTo(valImg, CV_32S, 256);
+
+        // position of every class in the class matrix and its diffusion weights
+        // in 1/256 for the neighbours of higher class
+        struct Neighbour { int dx; int dy; int weight; };
+        const auto& classMatrix = this->classMatrices.at(type);
+        const auto n = classMatrix.rows;
+        std::vector<cv::Point> positions(n * n);
+        std::vector<std::vector<Neighbour>> neighbours(n * n);
+        for (int cy = 0; cy < n; ++cy)
+        {
+            for (int cx = 0; cx < n; ++cx)
+            {
+                const auto cls = classMatrix.at<uint8_t>(cy, cx);
+                positions[cls] = cv::Point(cx, cy);
+                int weightSum = 0;
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        const auto nbCls = classMatrix.at<uint8_t>((cy + dy + n) % n, (cx + dx + n) % n);
+                        if (nbCls > cls)
+                        {
+                            const auto weight = (dx != 0 && dy != 0) ? 1 : 2;
+                            neighbours[cls].push_back({dx, dy, weight});
+                            weightSum += weight;
+                        }
+                    }
+                }
+                for (auto& nb : neighbours[cls])
+                {
+                    nb.weight = nb.weight * 256 / weightSum;
+                }
+            }
+        }
+
+        // all pixels of one class are at least n pixels apart, so their
+        // neighbourhoods do not overlap and the rows of tiles run in parallel
+        for (int cls = 0; cls < n * n; ++cls)
+        {
+            const auto pos = positions[cls];
+            const auto& clsNeighbours = neighbours[cls];
+            const auto tileRows = (imgHeight - pos.y + n - 1) / n;
+            cv::parallel_for_(cv::Range(0, std::max(tileRows, 0)), [&](const cv::Range& range)
+            {
+                for (int tileRow = range.start; tileRow < range.end; ++tileRow)
+                {
+                    const auto y = tileRow * n + pos.y;
+                    const auto valRow = valImg.ptr<int32_t>(y);
+                    const auto dithRow = img.ptr<uint8_t>(y);
+                    for (int x = pos.x; x < imgWidth; x += n)
+                    {
+                        const auto newPxlVal = (valRow[x] < 128 * 256) ? 0 : 255;
+                        const auto err = valRow[x] - newPxlVal * 256;
+                        dithRow[x] = (uint8_t)newPxlVal;
+                        for (const auto& nb : clsNeighbours)
+                        {
+                            const auto nbX = x + nb.dx;
+                            const auto nbY = y + nb.dy;
+                            if ((nbX >= 0) && (nbX < imgWidth) && (nbY >= 0) && (nbY < imgHeight))
+                            {
+                                valImg.ptr<int32_t>(nbY)[nbX] += err * nb.weight / 256;
+                            }
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+
+    cv::Mat MonochromDither::amScreen(const cv::Mat& srcImg, const double angle, const double lpi, const double dpi)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        amScreenInPlace(dithImg, angle, lpi, dpi);
+        return dithImg;
+    }
+
+
+    void MonochromDither::amScreenInPlace(cv::Mat& img, const double angle, const double lpi, const double dpi)
+    {
+        const auto tile = screenTile(angle, lpi, dpi);
+        ThresholdRows rows(tile, img.cols);
+        ditherRows(rows, img, img);
+    }
+
+
+    std::vector<cv::Mat> MonochromDither::cmykScreen(const cv::Mat& srcImg, const double dpi,
+                                                     const Screen cyan, const Screen magenta,
+                                                     const Screen yellow, const Screen black)
+    {
+        CV_Assert(srcImg.type() == CV_8UC3);
         const auto imgWidth = srcImg.cols;
         const auto imgHeight = srcImg.rows;
-        cv::Mat dithImg;
-        cv::cvtColor(srcImg, dithImg, cv::COLOR_BGR2GRAY);  
+
+        // separations hold the paper white left by each ink, so that they can
+        // be screened like grey images
+        std::vector<cv::Mat> separations(4);
+        for (auto& separation : separations)
+        {
+            separation.create(srcImg.size(), CV_8UC1);
+        }
         for (int y = 0; y < imgHeight; ++y)
-        {      
+        {
+            const auto srcRow = srcImg.ptr<cv::Vec3b>(y);
+            auto cRow = separations[0].ptr<uint8_t>(y);
+            auto mRow = separations[1].ptr<uint8_t>(y);
+            auto yRow = separations[2].ptr<uint8_t>(y);
+            auto kRow = separations[3].ptr<uint8_t>(y);
             for (int x = 0; x < imgWidth; ++x)
             {
-                uint8_t oldPxlVal = dithImg.at<uint8_t>(y, x);
-                uint8_t newPxlVal = (oldPxlVal < 127) ? 0 : 255;
-                dithImg.at<uint8_t>(y, x) = newPxlVal;
-                int8_t err = oldPxlVal - newPxlVal;
-                if ((y != (imgHeight-1)) && (x != 0) && (x != (imgWidth-1)))
-                {
-                    dithImg.at<uint8_t>(y+0, x+1) = saturated_add(dithImg.at<uint8_t>(y+0, x+1), (err * 7) / 16);
-                    dithImg.at<uint8_t>(y+1, x+1) = saturated_add(dithImg.at<uint8_t>(y+1, x+1), (err * 1) / 16);
-                    dithImg.at<uint8_t>(y+1, x+0) = saturated_add(dithImg.at<uint8_t>(y+1, x+0), (err * 5) / 16);
-                    dithImg.at<uint8_t>(y+1, x-1) = saturated_add(dithImg.at<uint8_t>(y+1, x-1), (err * 3) / 16);
-                }
-            } 
+                const int b = srcRow[x][0];
+                const int g = srcRow[x][1];
+                const int r = srcRow[x][2];
+                const auto white = std::max(r, std::max(g, b));
+                kRow[x] = (uint8_t)white;
+                cRow[x] = (uint8_t)((white == 0) ? 255 : 255 - (white - r) * 255 / white);
+                mRow[x] = (uint8_t)((white == 0) ? 255 : 255 - (white - g) * 255 / white);
+                yRow[x] = (uint8_t)((white == 0) ? 255 : 255 - (white - b) * 255 / white);
+            }
         }
+
+        const Screen screens[] = {cyan, magenta, yellow, black};
+        std::vector<cv::Mat> dithImgs(4);
+        cv::parallel_for_(cv::Range(0, 4), [&](const cv::Range& range)
+        {
+            for (int i = range.start; i < range.end; ++i)
+            {
+                ThresholdRows rows(screenTile(screens[i].angle, screens[i].lpi, dpi), imgWidth);
+                ditherRows(rows, separations[i], dithImgs[i]);
+            }
+        });
+        return dithImgs;
+    }
+
+
+    cv::Mat MonochromDither::ostromoukhov(const cv::Mat& srcImg, const bool serpentine)
+    {
+        cv::Mat dithImg;
+        toGray(srcImg, dithImg);
+        ostromoukhovInPlace(dithImg, serpentine);
         return dithImg;
     }
+
+
+    void MonochromDither::ostromoukhovInPlace(cv::Mat& img, const bool serpentine)
+    {
+        const auto imgWidth = img.cols;
+        const auto imgHeight = img.rows;
+
+        // weights in 1/256 indexed by the input level, the down weight takes
+        // the rounding remainder so that no error gets lost
+        int weightRight[256];
+        int weightDownLeft[256];
+        for (int level = 0; level < 256; ++level)
+        {
+            const auto coefs = ostromoukhovCoefs[(level < 128) ? level : 255 - level];
+            weightRight[level] = coefs[0] * 256 / coefs[3];
+            weightDownLeft[level] = coefs[1] * 256 / coefs[3];
+        }
+
+        // errors in 1/256 of the current and the next row, padded by one pixel
+        // on each side so the diffusion does not need to test for the border
+        std::vector<int> errBuffer(2 * (imgWidth + 2), 0);
+        auto errCur = errBuffer.data() + 1;
+        auto errNext = errBuffer.data() + 1 + (imgWidth + 2);
+        for (int y = 0; y < imgHeight; ++y)
+        {
+            auto row = img.ptr<uint8_t>(y);
+            const auto reverse = serpentine && (y % 2 == 1);
+            const auto dir = reverse ? -1 : 1;
+            const auto end = reverse ? -1 : imgWidth;
+            for (int x = reverse ? imgWidth - 1 : 0; x != end; x += dir)
+            {
+                const int level = row[x];
+                const auto val = (level << 8) + errCur[x];
+                const auto newPxlVal = (val < (128 << 8)) ? 0 : 255;
+                const auto err = val - (newPxlVal << 8);
+                const auto errRight = err * weightRight[level] / 256;
+                const auto errDownLeft = err * weightDownLeft[level] / 256;
+                errCur[x+dir] += errRight;
+                errNext[x-dir] += errDownLeft;
+                errNext[x] += err - errRight - errDownLeft;
+                row[x] = (uint8_t)newPxlVal;
+            }
+            std::swap(errCur, errNext);
+            std::fill(errNext - 1, errNext + imgWidth + 1, 0);
+        }
+    }
+
+
+    std::unique_ptr<Dither::RowDither> MonochromDither::rowDither(const METHOD method, const int width)
+    {
+        switch (method)
+        {
+            case METHOD::fixed_threshold:
+                return std::unique_ptr<RowDither>(new ThresholdRows(cv::Mat(1, 1, CV_8UC1, cv::Scalar::all(defaultThreshold)), width));
+            case METHOD::ordered_dither:
+                return std::unique_ptr<RowDither>(new ThresholdRows(orderedThresholds(defaultMapType), width));
+            case METHOD::am_screen:
+                return std::unique_ptr<RowDither>(new ThresholdRows(screenTile(defaultScreen.angle, defaultScreen.lpi, defaultDpi), width));
+            case METHOD::floyd_steinberg:
+                return std::unique_ptr<RowDither>(new FloydSteinbergRows(width));
+            default:
+                return std::unique_ptr<RowDither>();
+        }
+    }
+
+
+    cv::Mat MonochromDither::applyInPlace(cv::Mat& grayImg, const METHOD method)
+    {
+        CV_Assert(grayImg.type() == CV_8UC1);
+        switch (method)
+        {
+            case METHOD::fixed_threshold:
+                fixedTresholdInPlace(grayImg, defaultThreshold);
+                return grayImg;
+            case METHOD::noise_threshold:
+                noiseTresholdInPlace(grayImg, defaultNoiseThreshold, defaultThreshold);
+                return grayImg;
+            case METHOD::random_dither:
+                randomInPlace(grayImg);
+                return grayImg;
+            case METHOD::clustered_pattern:
+                patternedInPlace(grayImg, PATTERN_TYPE::clustered);
+                return grayImg;
+            case METHOD::dispersed_pattern:
+                patternedInPlace(grayImg, PATTERN_TYPE::dispersed);
+                return grayImg;
+            case METHOD::ordered_dither:
+                orderedInPlace(grayImg, defaultMapType);
+                return grayImg;
+            case METHOD::simple_error_diffusion:
+                simpleErrorDiffusionInPlace(grayImg);
+                return grayImg;
+            case METHOD::floyd_steinberg:
+                floydSteinbergInPlace(grayImg);
+                return grayImg;
+            case METHOD::riemersma_dither:
+                riemersmaInPlace(grayImg);
+                return grayImg;
+            case METHOD::block_error_diffusion:
+                blockErrorDiffusionInPlace(grayImg, defaultTileSize);
+                return grayImg;
+            case METHOD::dot_diffusion:
+                dotDiffusionInPlace(grayImg, defaultClassMatrix);
+                return grayImg;
+            case METHOD::am_screen:
+                amScreenInPlace(grayImg, defaultScreen.angle, defaultScreen.lpi, defaultDpi);
+                return grayImg;
+            case METHOD::ostromoukhov_diffusion:
+                ostromoukhovInPlace(grayImg, defaultSerpentine);
+                return grayImg;
+        }
+        CV_Error(cv::Error::StsBadArg, "unknown dithering method");
+    }
 }
@@ -0,0 +1,351 @@
+#include "Pipeline.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <numeric>
+
+
+namespace
+{
+    // A step of the pipeline which produces its output row by row.  Rows have
+    // to be requested in non-decreasing order, the last depth rows stay
+    // available so that the following step can work on a window of rows.
+    class RowStage
+    {
+    public:
+        RowStage(const cv::Size size, const int depth, const uint8_t* lut)
+            : size(size), depth(depth), lut(lut), buffer(size.width * depth), next(0) {}
+
+        virtual ~RowStage() {}
+
+        const uint8_t* row(const int y)
+        {
+            // rows the following step has skipped are never computed
+            next = std::max(next, y - depth + 1);
+            while (next <= y)
+            {
+                auto out = slot(next);
+                compute(next, out);
+                if (lut != nullptr)
+                {
+                    for (int x = 0; x < size.width; ++x)
+                    {
+                        out[x] = lut[out[x]];
+                    }
+                }
+                ++next;
+            }
+            return slot(y);
+        }
+
+    public:
+        const cv::Size size;
+
+    protected:
+        virtual void compute(const int y, uint8_t* out) = 0;
+
+    private:
+        uint8_t* slot(const int y)
+        {
+            return buffer.data() + (y % depth) * size.width;
+        }
+
+        const int depth;
+        const uint8_t* lut;
+        std::vector<uint8_t> buffer;
+        int next;
+    };
+
+
+    // reads the source image and converts it to grey
+    class SourceStage : public RowStage
+    {
+    public:
+        SourceStage(const cv::Mat& srcImg, const int depth, const uint8_t* lut)
+            : RowStage(srcImg.size(), depth, lut), srcImg(srcImg) {}
+
+    protected:
+        void compute(const int y, uint8_t* out) override
+        {
+            const auto srcRow = srcImg.ptr<uint8_t>(y);
+            if (srcImg.channels() == 1)
+            {
+                memcpy(out, srcRow, size.width);
+                return;
+            }
+            // same fixed point weights as cv::COLOR_BGR2GRAY
+            for (int x = 0; x < size.width; ++x)
+            {
+                const auto bgr = srcRow + 3 * x;
+                out[x] = (uint8_t)((bgr[0] * 1868 + bgr[1] * 9617 + bgr[2] * 4899 + (1 << 13)) >> 14);
+            }
+        }
+
+    private:
+        const cv::Mat& srcImg;
+    };
+
+
+    class UnsharpStage : public RowStage
+    {
+    public:
+        UnsharpStage(RowStage& input, const int depth, const uint8_t* lut, const double amount)
+            : RowStage(input.size, depth, lut), input(input),
+              amount((int)std::lround(amount * 256.)), columnSum(input.size.width) {}
+
+    protected:
+        void compute(const int y, uint8_t* out) override
+        {
+            const auto lastRow = size.height - 1;
+            const auto above = input.row(std::max(y - 1, 0));
+            const auto center = input.row(y);
+            const auto below = input.row(std::min(y + 1, lastRow));
+            const auto lastCol = size.width - 1;
+            for (int x = 0; x <= lastCol; ++x)
+            {
+                columnSum[x] = above[x] + 2 * center[x] + below[x];
+            }
+            // 1 2 1 Gaussian in both directions, blur is in 1/16
+            for (int x = 0; x <= lastCol; ++x)
+            {
+                const auto blur = columnSum[std::max(x - 1, 0)] + 2 * columnSum[x] + columnSum[std::min(x + 1, lastCol)];
+                const auto detail = center[x] * 16 - blur;
+                out[x] = cv::saturate_cast<uint8_t>(center[x] + detail * amount / (16 * 256));
+            }
+        }
+
+    private:
+        RowStage& input;
+        const int amount;
+        std::vector<int> columnSum;
+    };
+
+
+    class ResizeStage : public RowStage
+    {
+    public:
+        ResizeStage(RowStage& input, const cv::Size size, const int depth, const uint8_t* lut)
+            : RowStage(size, depth, lut), input(input), srcX(size.width), weightX(size.width)
+        {
+            for (int x = 0; x < size.width; ++x)
+            {
+                sourcePosition(x, size.width, input.size.width, srcX[x], weightX[x]);
+            }
+        }
+
+    protected:
+        void compute(const int y, uint8_t* out) override
+        {
+            int srcY, weightY;
+            sourcePosition(y, size.height, input.size.height, srcY, weightY);
+            const auto lastRow = input.size.height - 1;
+            const auto lastCol = input.size.width - 1;
+            const auto top = input.row(srcY);
+            const auto bottom = input.row(std::min(srcY + 1, lastRow));
+            for (int x = 0; x < size.width; ++x)
+            {
+                const auto x0 = srcX[x];
+                const auto x1 = std::min(x0 + 1, lastCol);
+                const auto wx = weightX[x];
+                const auto upper = top[x0] * (256 - wx) + top[x1] * wx;
+                const auto lower = bottom[x0] * (256 - wx) + bottom[x1] * wx;
+                out[x] = (uint8_t)((upper * (256 - weightY) + lower * weightY + (1 << 15)) >> 16);
+            }
+        }
+
+    private:
+        // pixel centres are aligned like in cv::resize, the weight of the
+        // following source pixel is in 1/256
+        static void sourcePosition(const int dst, const int dstLength, const int srcLength, int& src, int& weight)
+        {
+            const auto pos = (dst + .5) * srcLength / dstLength - .5;
+            if (pos <= 0.)
+            {
+                src = 0;
+                weight = 0;
+                return;
+            }
+            src = std::min((int)pos, srcLength - 1);
+            weight = (int)std::lround((pos - src) * 256.);
+        }
+
+        RowStage& input;
+        std::vector<int> srcX;
+        std::vector<int> weightX;
+    };
+}
+
+
+namespace dither
+{
+    std::vector<uint8_t>& Pipeline::pointStage()
+    {
+        // successive point operations are composed into one table
+        if (this->stages.empty() || this->stages.back().type != STAGE_TYPE::lookup)
+        {
+            Stage stage;
+            stage.type = STAGE_TYPE::lookup;
+            stage.lut.resize(256);
+            std::iota(stage.lut.begin(), stage.lut.end(), 0);
+            stage.amount = 0.;
+            this->stages.push_back(stage);
+        }
+        return this->stages.back().lut;
+    }
+
+
+    Pipeline& Pipeline::gamma(const double gamma)
+    {
+        CV_Assert(gamma > 0.);
+        for (auto& val : pointStage())
+        {
+            val = cv::saturate_cast<uint8_t>(255. * std::pow(val / 255., gamma));
+        }
+        return *this;
+    }
+
+
+    Pipeline& Pipeline::contrast(const uint8_t low, const uint8_t high)
+    {
+        CV_Assert(low < high);
+        for (auto& val : pointStage())
+        {
+            val = cv::saturate_cast<uint8_t>((val - low) * 255. / (high - low));
+        }
+        return *this;
+    }
+
+
+    Pipeline& Pipeline::unsharp(const double amount)
+    {
+        Stage stage;
+        stage.type = STAGE_TYPE::unsharp_mask;
+        stage.amount = amount;
+        this->stages.push_back(stage);
+        return *this;
+    }
+
+
+    Pipeline& Pipeline::resize(const cv::Size size)
+    {
+        CV_Assert(size.width > 0 && size.height > 0);
+        Stage stage;
+        stage.type = STAGE_TYPE::bilinear_resize;
+        stage.amount = 0.;
+        stage.size = size;
+        this->stages.push_back(stage);
+        return *this;
+    }
+
+
+    cv::Size Pipeline::outputSize(const cv::Size srcSize) const
+    {
+        auto dstSize = srcSize;
+        for (const auto& stage : this->stages)
+        {
+            if (stage.type == STAGE_TYPE::bilinear_resize)
+            {
+                dstSize = stage.size;
+            }
+        }
+        return dstSize;
+    }
+
+
+    cv::Mat Pipeline::run(const cv::Mat& srcImg, Dither::RowDither* rowDither) const
+    {
+        CV_Assert(srcImg.type() == CV_8UC1 || srcImg.type() == CV_8UC3);
+
+        // every lookup table is applied by the step in front of it, the source
+        // conversion being the first step
+        std::vector<const Stage*> steps(1, nullptr);
+        std::vector<const uint8_t*> luts(1, nullptr);
+        for (const auto& stage : this->stages)
+        {
+            if (stage.type == STAGE_TYPE::lookup)
+            {
+                luts.back() = stage.lut.data();
+                continue;
+            }
+            steps.push_back(&stage);
+            luts.push_back(nullptr);
+        }
+
+        // an empty image stays empty, also behind a resize
+        if (srcImg.empty())
+        {
+            return cv::Mat();
+        }
+
+        // a row dither which depends on the previous rows gets them in one band
+        const auto dstSize = outputSize(srcImg.size());
+        cv::Mat dstImg(dstSize, CV_8UC1);
+        const auto bandHeight = (rowDither == nullptr || rowDither->parallel()) ? 64 : dstSize.height;
+        const auto bands = (dstSize.height + bandHeight - 1) / bandHeight;
+        cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range)
+        {
+            for (int band = range.start; band < range.end; ++band)
+            {
+                // each band streams through its own chain of row buffers, a
+                // step keeps as many rows as the step after it looks at
+                std::vector<std::unique_ptr<RowStage>> chain;
+                for (size_t i = 0; i < steps.size(); ++i)
+                {
+                    const auto next = (i + 1 < steps.size()) ? steps[i + 1] : nullptr;
+                    const auto depth = (next == nullptr) ? 1 : (next->type == STAGE_TYPE::unsharp_mask) ? 3 : 2;
+                    if (steps[i] == nullptr)
+                    {
+                        chain.emplace_back(new SourceStage(srcImg, depth, luts[i]));
+                    }
+                    else if (steps[i]->type == STAGE_TYPE::unsharp_mask)
+                    {
+                        chain.emplace_back(new UnsharpStage(*chain.back(), depth, luts[i], steps[i]->amount));
+                    }
+                    else
+                    {
+                        chain.emplace_back(new ResizeStage(*chain.back(), steps[i]->size, depth, luts[i]));
+                    }
+                }
+                const auto endY = std::min((band + 1) * bandHeight, dstSize.height);
+                for (int y = band * bandHeight; y < endY; ++y)
+                {
+                    if (rowDither != nullptr)
+                    {
+                        rowDither->push(y, chain.back()->row(y), dstImg.ptr<uint8_t>(y));
+                    }
+                    else
+                    {
+                        memcpy(dstImg.ptr<uint8_t>(y), chain.back()->row(y), dstSize.width);
+                    }
+                }
+            }
+        });
+        if (rowDither != nullptr)
+        {
+            rowDither->finish();
+        }
+        return dstImg;
+    }
+
+
+    cv::Mat Pipeline::process(const cv::Mat& srcImg) const
+    {
+        return run(srcImg, nullptr);
+    }
+
+
+    cv::Mat Pipeline::apply(const cv::Mat& srcImg, Dither& dither, const METHOD method) const
+    {
+        // methods working row by row dither the rows as they leave the last
+        // step, the others get the preprocessed image without another copy
+        const auto rowDither = dither.rowDither(method, outputSize(srcImg.size()).width);
+        if (rowDither)
+        {
+            return run(srcImg, rowDither.get());
+        }
+        auto grayImg = run(srcImg, nullptr);
+        return dither.applyInPlace(grayImg, method);
+    }
+}
@@ -0,0 +1,198 @@
+#include "Selector.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+    // From the best looking to the roughest result.  The methods are ranked by
+    // the deviation of their Gaussian (sigma 1.5) filtered dither of a grey
+    // ramp from the filtered ramp, a model of viewing the halftone from a
+    // distance; the rms deviation in grey levels is given for each.  Two kinds
+    // of artefacts the measure does not see are ranked by hand: the AM screen
+    // is made for print, where its dot clusters are too fine to be seen, and
+    // stays next to the ordered dither; the streaks of the right-only simple
+    // error diffusion and the grain of random noise are ranked below the
+    // regular screens and patterns.
+    const dither::METHOD qualityRanking[] =
+    {
+        dither::METHOD::ostromoukhov_diffusion,     //  2.5
+        dither::METHOD::block_error_diffusion,      //  2.7
+        dither::METHOD::floyd_steinberg,            //  2.9
+        dither::METHOD::dot_diffusion,              //  6.4
+        dither::METHOD::riemersma_dither,           //  7.6
+        dither::METHOD::ordered_dither,             //  9.1
+        dither::METHOD::am_screen,                  // 34.5
+        dither::METHOD::simple_error_diffusion,     // 15.6
+        dither::METHOD::dispersed_pattern,          // 28.4
+        dither::METHOD::clustered_pattern,          // 29.4
+        dither::METHOD::random_dither,              // 20.2
+        dither::METHOD::noise_threshold,            // 57.3
+        dither::METHOD::fixed_threshold             // 74.4
+    };
+
+
+    cv::Mat createCalibrationImage(const int size)
+    {
+        // grey ramp with a vertical wave so that all grey levels occur
+        cv::Mat img(size, size, CV_8UC3);
+        for (int y = 0; y < size; ++y)
+        {
+            const auto wave = 32. * std::sin(2. * CV_PI * y / size);
+            for (int x = 0; x < size; ++x)
+            {
+                const auto val = cv::saturate_cast<uint8_t>(255. * x / (size - 1) + wave);
+                img.at<cv::Vec3b>(y, x) = cv::Vec3b::all(val);
+            }
+        }
+        return img;
+    }
+
+
+    // median of a few runs after a warm up run, which fills lazily built tables
+    double measureMs(dither::Dither& dither, const dither::METHOD method, const cv::Mat& img)
+    {
+        dither.apply(img, method);
+        std::vector<double> times;
+        for (int i = 0; i < 3; ++i)
+        {
+            cv::TickMeter tm;
+            tm.start();
+            dither.apply(img, method);
+            tm.stop();
+            times.push_back(tm.getTimeMilli());
+        }
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+}
+
+
+namespace dither
+{
+    Selector::Selector(Dither& dither) : dither(dither), calibrated(false)
+    {
+    }
+
+
+    void Selector::calibrate()
+    {
+        std::lock_guard<std::mutex> lock(this->calibrationMutex);
+        if (this->calibrated)
+        {
+            return;
+        }
+        const int smallSize = 128;
+        const int largeSize = 512;
+        const auto smallImg = createCalibrationImage(smallSize);
+        const auto largeImg = createCalibrationImage(largeSize);
+        const auto pixels = (double)(largeSize * largeSize - smallSize * smallSize);
+        // costs are only kept once the calibration is complete, an exception
+        // leaves it undone and the next call starts from scratch
+        std::vector<Cost> measured;
+        for (const auto method : qualityRanking)
+        {
+            double smallMs, largeMs;
+            try
+            {
+                smallMs = measureMs(this->dither, method, smallImg);
+                largeMs = measureMs(this->dither, method, largeImg);
+            }
+            catch (const std::exception&)
+            {
+                // a method the Dither cannot run is never chosen
+                continue;
+            }
+            // time = overhead + pixels * pixelMs through both measurements
+            Cost cost;
+            cost.method = method;
+            cost.pixelMs = std::max(largeMs - smallMs, 0.) / pixels;
+            cost.overheadMs = std::max(smallMs - cost.pixelMs * smallSize * smallSize, 0.);
+            measured.push_back(cost);
+        }
+        this->calibration.swap(measured);
+        this->calibrated = true;
+    }
+
+
+    std::vector<Selector::Cost> Selector::costs()
+    {
+        calibrate();
+        return this->calibration;
+    }
+
+
+    void Selector::setCosts(const std::vector<Cost>& costs)
+    {
+        std::lock_guard<std::mutex> lock(this->calibrationMutex);
+        this->calibration = costs;
+        this->calibrated = true;
+    }
+
+
+    const Selector::Cost* Selector::findCost(const METHOD method) const
+    {
+        for (const auto& cost : this->calibration)
+        {
+            if (cost.method == method)
+            {
+                return &cost;
+            }
+        }
+        return nullptr;
+    }
+
+
+    double Selector::predict(const METHOD method, const cv::Size size)
+    {
+        calibrate();
+        const auto cost = findCost(method);
+        if (cost == nullptr)
+        {
+            CV_Error(cv::Error::StsBadArg, "dithering method could not be calibrated");
+        }
+        return cost->overheadMs + cost->pixelMs * size.area();
+    }
+
+
+    Selector::Choice Selector::choose(const cv::Size size, const double budgetMs)
+    {
+        calibrate();
+        if (this->calibration.empty())
+        {
+            CV_Error(cv::Error::StsError, "no dithering method could be calibrated");
+        }
+        // costs handed over by setCosts may come in any order
+        Choice fastest = {METHOD::fixed_threshold, -1., false};
+        for (const auto method : qualityRanking)
+        {
+            const auto cost = findCost(method);
+            if (cost == nullptr)
+            {
+                continue;
+            }
+            const auto predictedMs = cost->overheadMs + cost->pixelMs * size.area();
+            if (predictedMs <= budgetMs)
+            {
+                return {method, predictedMs, true};
+            }
+            if (fastest.predictedMs < 0. || predictedMs < fastest.predictedMs)
+            {
+                fastest = {method, predictedMs, false};
+            }
+        }
+        return fastest;
+    }
+
+
+    cv::Mat Selector::apply(const cv::Mat& srcImg, const double budgetMs, Choice* choice)
+    {
+        const auto chosen = choose(srcImg.size(), budgetMs);
+        if (choice != nullptr)
+        {
+            *choice = chosen;
+        }
+        return this->dither.apply(srcImg, chosen.method);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef DITHER_SEAM_VISIBILITY_HPP
+#define DITHER_SEAM_VISIBILITY_HPP
+
+#include <algorithm>
+
+#include "opencv2/core.hpp"
+#include "opencv2/imgproc.hpp"
+
+
+// Compares what an observer sees, i.e. low pass filtered halftones, against an
+// exact diffusion and relates the deviation on tile borders to the deviation
+// inside the tiles; a ratio close to 1 means the seams are not visible.
+inline double seamVisibility(const cv::Mat& dithImg, const cv::Mat& refImg, const int tileSize)
+{
+    cv::Mat dithBlur, refBlur, diff;
+    cv::GaussianBlur(dithImg, dithBlur, cv::Size(0, 0), 2.);
+    cv::GaussianBlur(refImg, refBlur, cv::Size(0, 0), 2.);
+    cv::absdiff(dithBlur, refBlur, diff);
+    double seamSum = 0., innerSum = 0.;
+    int seamCount = 0, innerCount = 0;
+    for (int y = 0; y < diff.rows; ++y)
+    {
+        for (int x = 0; x < diff.cols; ++x)
+        {
+            const auto dy = std::min(y % tileSize, tileSize - 1 - y % tileSize);
+            const auto dx = std::min(x % tileSize, tileSize - 1 - x % tileSize);
+            const auto val = diff.at<uint8_t>(y, x);
+            if (std::min(dx, dy) < 2)
+            {
+                seamSum += val;
+                ++seamCount;
+            }
+            else
+            {
+                innerSum += val;
+                ++innerCount;
+            }
+        }
+    }
+    if (seamCount == 0 || innerCount == 0 || innerSum == 0.)
+    {
+        return 1.;
+    }
+    return (seamSum / seamCount) / (innerSum / innerCount);
+}
+
+
+#endif //DITHER_SEAM_VISIBILITY_HPP
@@ -0,0 +1,59 @@
+#include <iomanip>
+#include <iostream>
+
+#include "opencv2/imgproc.hpp"
+#include "MonochromDither.hpp"
+
+
+using namespace std;
+using namespace cv;
+using namespace dither;
+
+
+namespace
+{
+    // The criterion the optimized class matrices were derived with: squared
+    // error between flat grey patches and their Gaussian (sigma 1.5) filtered
+    // dot diffusion, summed over 8 grey levels.  The patch border is left out
+    // since the filter sees beyond it there.
+    double filteredError(MonochromDither& monochromDither, const CLASS_MATRIX_TYPE type)
+    {
+        const int size = 128;
+        const int margin = 8;
+        auto error = 0.;
+        for (int level = 1; level <= 8; ++level)
+        {
+            const auto val = level * 255. / 9.;
+            const Mat img(size, size, CV_8UC1, Scalar::all(val));
+            Mat dithImg, blurImg;
+            monochromDither.dotDiffusion(img, type).convertTo(dithImg, CV_32F);
+            GaussianBlur(dithImg, blurImg, Size(0, 0), 1.5);
+            for (int y = margin; y < size - margin; ++y)
+            {
+                for (int x = margin; x < size - margin; ++x)
+                {
+                    const auto diff = blurImg.at<float>(y, x) - val;
+                    error += diff * diff;
+                }
+            }
+        }
+        return error / ((size - 2 * margin) * (size - 2 * margin));
+    }
+}
+
+
+int main()
+{
+    MonochromDither monochromDither;
+    const auto knuth = filteredError(monochromDither, CLASS_MATRIX_TYPE::knuth_8x8);
+    const auto optimized8 = filteredError(monochromDither, CLASS_MATRIX_TYPE::optimized_8x8);
+    const auto optimized16 = filteredError(monochromDither, CLASS_MATRIX_TYPE::optimized_16x16);
+    cout << fixed << setprecision(1)
+         << "knuth 8x8: " << knuth << ", optimized 8x8: " << optimized8 << ", optimized 16x16: " << optimized16 << "\n";
+    if (optimized8 >= knuth || optimized16 >= knuth)
+    {
+        cerr << "optimized class matrices do not beat Knuth's matrix\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include "MonochromDither.hpp"
+#include "SeamVisibility.hpp"
+
+
+using namespace std;
+using namespace cv;
+using namespace dither;
+
+
+namespace
+{
+    // the error crosses the tile borders, so the borders must not deviate
+    // from the serial diffusion more than the inside of the tiles
+    const int tileSizes[] = {2, 17, 64};
+    const double maxRatio = 1.1;
+
+
+    Mat createRamp(const int size)
+    {
+        Mat img(size, size, CV_8UC1);
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                img.at<uint8_t>(y, x) = saturate_cast<uint8_t>(255. * x / (size - 1) + 32. * sin(2. * CV_PI * y / size));
+            }
+        }
+        return img;
+    }
+
+
+    Mat createWaves(const int size)
+    {
+        Mat img(size, size, CV_8UC1);
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                img.at<uint8_t>(y, x) = saturate_cast<uint8_t>(128. + 100. * sin(x / 23.) * cos(y / 31.));
+            }
+        }
+        return img;
+    }
+}
+
+
+int main()
+{
+    MonochromDither monochromDither;
+    auto failed = false;
+    for (const auto& img : {createRamp(256), createWaves(256)})
+    {
+        // a single tile covering the image is the serial diffusion
+        const auto refImg = monochromDither.blockErrorDiffusion(img, img.cols);
+        for (const auto tileSize : tileSizes)
+        {
+            const auto dithImg = monochromDither.blockErrorDiffusion(img, tileSize);
+            const auto ratio = seamVisibility(dithImg, refImg, tileSize);
+            const auto differing = (int)(norm(dithImg, refImg, NORM_L1) / 255.);
+            cout << fixed << setprecision(3)
+                 << "tile " << tileSize << ": ratio " << ratio << ", differing pixels " << differing << "\n";
+            if (ratio > maxRatio || differing != 0)
+            {
+                cerr << "block error diffusion deviates at the tile borders\n";
+                failed = true;
+            }
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "MonochromDither.hpp"
+#include "Selector.hpp"
+
+
+using namespace std;
+using namespace cv;
+using namespace dither;
+
+
+namespace
+{
+    bool check(const bool condition, const char* message)
+    {
+        if (!condition)
+        {
+            cerr << message << "\n";
+        }
+        return condition;
+    }
+}
+
+
+int main()
+{
+    MonochromDither monochromDither;
+    Selector selector(monochromDither);
+
+    // known costs for a 1000 x 1000 image, deliberately not in ranking order
+    const Size size(1000, 1000);
+    const vector<Selector::Cost> costs =
+    {
+        {METHOD::ordered_dither, 1., 0.},
+        {METHOD::simple_error_diffusion, 1., 0.},
+        {METHOD::ostromoukhov_diffusion, 0., 100. / size.area()},
+        {METHOD::floyd_steinberg, 2., 8. / size.area()}
+    };
+    selector.setCosts(costs);
+
+    auto passed = check(selector.costs().size() == costs.size(), "costs are not kept");
+    passed &= check(std::abs(selector.predict(METHOD::floyd_steinberg, size) - 10.) < 1e-9, "wrong prediction");
+
+    // the best method within the budget wins
+    auto choice = selector.choose(size, 1000.);
+    passed &= check(choice.method == METHOD::ostromoukhov_diffusion && choice.withinBudget, "best method not chosen");
+    choice = selector.choose(size, 50.);
+    passed &= check(choice.method == METHOD::floyd_steinberg && choice.withinBudget
+                    && std::abs(choice.predictedMs - 10.) < 1e-9, "best method within budget not chosen");
+
+    // ordered dither ranks above the equally fast simple error diffusion
+    choice = selector.choose(size, 5.);
+    passed &= check(choice.method == METHOD::ordered_dither && choice.withinBudget, "ranking of ordered dither");
+
+    // over budget the fastest method is taken, the first one if several tie
+    choice = selector.choose(size, .5);
+    passed &= check(choice.method == METHOD::ordered_dither && !choice.withinBudget
+                    && choice.predictedMs == 1., "fastest method not chosen over budget");
+    return passed ? 0 : 1;
+}